@@ -0,0 +1,135 @@
+// Expected core and memory availability of the hosts of a site, for walltime-aware backfilling (grid example).
+//
+// Every running job is recorded on its host with its expected end, i.e. its start plus its requested walltime.
+// The earliest time a host has room for a job shape (cores and memory) follows from the jobs running on that
+// host in order of expected end. These times are kept in one min segment tree over the hosts per shape, so the
+// shadow time of a waiting job (the earliest time and host it can start on) is a lookup, and starting or ending
+// a job only updates its own host. Sites see only a few shapes, so trees are built for the queried shapes only.
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <utility>
+#include <vector>
+
+class AvailabilityProfile {
+    public:
+        AvailabilityProfile() = default;
+
+        AvailabilityProfile(int hosts, int cores_per_host, double memory_per_host)
+            : hosts_(hosts), cores_(cores_per_host), memory_(memory_per_host), running_(hosts)
+        {
+            size_ = 1;
+            while (size_ < hosts_) {
+                size_ *= 2;
+            }
+        }
+
+        void start(int host, int cores, double memory, double end) {
+            std::vector<Entry>& jobs = running_[host];
+            auto it = std::upper_bound(jobs.begin(), jobs.end(), end, [](double t, const Entry& e) { return t < e.end; });
+            jobs.insert(it, {end, cores, memory});
+            refresh(host);
+        }
+
+        void finish(int host, int cores, double memory, double end) {
+            std::vector<Entry>& jobs = running_[host];
+            for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+                if (it->end == end && it->cores == cores && it->memory == memory) {
+                    jobs.erase(it);
+                    break;
+                }
+            }
+            refresh(host);
+        }
+
+        // Earliest expected time at which a host has room for the shape, and that host. The time is -infinity if a
+        // host has room already, and the host -1 if the shape is larger than a host.
+        std::pair<double, int> shadow(int cores, double memory) {
+            const std::vector<double>& tree = treeFor(cores, memory);
+            if (tree[1] == INFINITE) {
+                return {INFINITE, -1};
+            }
+            int n = 1;
+            while (n < size_) {
+                n = tree[2 * n] <= tree[2 * n + 1] ? 2 * n : 2 * n + 1;
+            }
+            return {tree[1], n - size_};
+        }
+
+        // Cores and memory still free on a host at the given time once a job of the given shape runs there too.
+        std::pair<int, double> extra(int host, double time, int cores, double memory) const {
+            int free_cores = cores_ - cores;
+            double free_memory = memory_ - memory;
+            for (const Entry& e : running_[host]) {
+                if (e.end > time) {
+                    free_cores -= e.cores;
+                    free_memory -= e.memory;
+                }
+            }
+            return {free_cores, free_memory};
+        }
+
+    private:
+        struct Entry {
+            double end;
+            int cores;
+            double memory;
+        };
+
+        static constexpr double INFINITE = std::numeric_limits<double>::infinity();
+
+        // Releases the jobs of a host in order of expected end until the shape fits.
+        double earliest(int host, int cores, double memory) const {
+            int free_cores = cores_;
+            double free_memory = memory_;
+            for (const Entry& e : running_[host]) {
+                free_cores -= e.cores;
+                free_memory -= e.memory;
+            }
+            if (free_cores >= cores && free_memory >= memory) {
+                return -INFINITE;
+            }
+            for (const Entry& e : running_[host]) {
+                free_cores += e.cores;
+                free_memory += e.memory;
+                if (free_cores >= cores && free_memory >= memory) {
+                    return e.end;
+                }
+            }
+            return INFINITE;
+        }
+
+        std::vector<double>& treeFor(int cores, double memory) {
+            auto [it, created] = trees_.try_emplace({cores, memory});
+            std::vector<double>& tree = it->second;
+            if (created) {
+                tree.assign(2 * size_, INFINITE);
+                for (int h = 0; h < hosts_; h++) {
+                    tree[size_ + h] = earliest(h, cores, memory);
+                }
+                for (int n = size_ - 1; n > 0; n--) {
+                    tree[n] = std::min(tree[2 * n], tree[2 * n + 1]);
+                }
+            }
+            return tree;
+        }
+
+        void refresh(int host) {
+            for (auto& [shape, tree] : trees_) {
+                int n = size_ + host;
+                tree[n] = earliest(host, shape.first, shape.second);
+                for (n /= 2; n > 0; n /= 2) {
+                    tree[n] = std::min(tree[2 * n], tree[2 * n + 1]);
+                }
+            }
+        }
+
+        int hosts_ = 0;
+        int cores_ = 0;
+        double memory_ = 0.0;
+        int size_ = 1;
+        std::vector<std::vector<Entry>> running_;                      // per host, by expected end
+        std::map<std::pair<int, double>, std::vector<double>> trees_;  // min earliest time per shape
+};
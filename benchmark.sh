@@ -0,0 +1,88 @@
+#!/usr/bin/env bash
+# Simple benchmark harness for simgrid_cluster_with_historical_errors.
+#
+# Builds the example in several configurations and reports the best wall-clock time
+# (and simulated jobs per wall-clock second) over a number of repetitions:
+#
+#   quiet     built with -DSIM_LOG_LEVEL=0 (no logging code in the job loop)
+#   muted     default build, run with --mute
+#   verbose   default build, log output discarded
+#   eventlog  default build, run with --mute and a binary --event-log
+#   baseline  (optional) the same source file taken from another git revision, run with --mute
+#
+# Usage:
+#   ./benchmark.sh [-n jobs] [-q queue] [-r repeats] [-b baseline-rev] [-- extra simulator args]
+#
+# The SimGrid location can be overridden with SIMGRID_PREFIX (default /usr/local).
+
+set -euo pipefail
+
+JOBS=100000
+QUEUE=BNL
+REPEATS=3
+BASELINE=""
+SRC=simgrid_cluster_with_historical_errors.cpp
+BUILD_DIR=bench_build
+SIMGRID_PREFIX=${SIMGRID_PREFIX:-/usr/local}
+CXXFLAGS=${CXXFLAGS:-"-O2"}
+
+while getopts "n:q:r:b:h" opt; do
+    case $opt in
+        n) JOBS=$OPTARG ;;
+        q) QUEUE=$OPTARG ;;
+        r) REPEATS=$OPTARG ;;
+        b) BASELINE=$OPTARG ;;
+        *) sed -n '2,16p' "$0"; exit 1 ;;
+    esac
+done
+shift $((OPTIND - 1))
+EXTRA_ARGS=("$@")
+
+mkdir -p "$BUILD_DIR"
+
+build() {
+    local out=$1 src=$2
+    shift 2
+    g++ -std=c++17 $CXXFLAGS "$@" -I. "$src" -o "$BUILD_DIR/$out" \
+        -I"$SIMGRID_PREFIX/include" -Wl,-rpath,"$SIMGRID_PREFIX/lib" -L"$SIMGRID_PREFIX/lib" -lsimgrid
+}
+
+# Run a binary REPEATS times and print the best wall-clock time in seconds.
+best_time() {
+    local best=""
+    for _ in $(seq "$REPEATS"); do
+        local start end t
+        start=$(date +%s.%N)
+        "$@" > /dev/null 2>&1
+        end=$(date +%s.%N)
+        t=$(echo "$end - $start" | bc -l)
+        if [ -z "$best" ] || [ "$(echo "$t < $best" | bc -l)" -eq 1 ]; then
+            best=$t
+        fi
+    done
+    echo "$best"
+}
+
+report() {
+    local label=$1 t=$2
+    printf "%-10s %10.3f s %14.0f jobs/s\n" "$label" "$t" "$(echo "$JOBS / $t" | bc -l)"
+}
+
+echo "Building configurations in $BUILD_DIR ..."
+build quiet "$SRC" -DSIM_LOG_LEVEL=0
+build default "$SRC"
+if [ -n "$BASELINE" ]; then
+    git show "$BASELINE:$SRC" > "$BUILD_DIR/baseline.cpp"
+    build baseline "$BUILD_DIR/baseline.cpp"
+fi
+
+ARGS=(--input error_codes.json --n "$JOBS" --queue "$QUEUE" "${EXTRA_ARGS[@]}")
+
+echo "Running $JOBS jobs on queue $QUEUE, best of $REPEATS"
+report quiet "$(best_time "$BUILD_DIR/quiet" "${ARGS[@]}")"
+report muted "$(best_time "$BUILD_DIR/default" "${ARGS[@]}" --mute)"
+report verbose "$(best_time "$BUILD_DIR/default" "${ARGS[@]}")"
+report eventlog "$(best_time "$BUILD_DIR/default" "${ARGS[@]}" --mute --event-log "$BUILD_DIR/events.bin")"
+if [ -n "$BASELINE" ]; then
+    report baseline "$(best_time "$BUILD_DIR/baseline" "${ARGS[@]}" --mute)"
+fi
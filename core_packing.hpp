@@ -0,0 +1,162 @@
+// Free-core and free-memory bookkeeping for packing jobs onto the hosts of a site (grid example).
+//
+// Every host has the same number of cores and the same memory. A segment tree over the hosts keeps the
+// maximum free cores and the maximum free memory of every subtree, so first-fit (lowest-numbered host
+// with enough free cores and memory) descends only into subtrees that can still fit. Buckets of hosts by
+// free core count answer best-fit (host with the fewest free cores that still fit). A reserved host is
+// hidden from all searches until it is released, so it can drain for a wide job.
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+class CorePacker {
+    public:
+        CorePacker() = default;
+
+        CorePacker(int hosts, int cores_per_host, double memory_per_host)
+            : hosts_(hosts), cores_(cores_per_host), memory_(memory_per_host), free_(hosts, cores_per_host),
+              free_memory_(hosts, memory_per_host), reserved_(hosts, false), buckets_(cores_per_host + 1), position_(hosts)
+        {
+            size_ = 1;
+            while (size_ < hosts_) {
+                size_ *= 2;
+            }
+            tree_.assign(2 * size_, 0);
+            tree_memory_.assign(2 * size_, -1.0);
+            for (int h = 0; h < hosts_; h++) {
+                tree_[size_ + h] = cores_;
+                tree_memory_[size_ + h] = memory_;
+                position_[h] = static_cast<int>(buckets_[cores_].size());
+                buckets_[cores_].push_back(h);
+            }
+            for (int n = size_ - 1; n > 0; n--) {
+                pull(n);
+            }
+        }
+
+        int coresPerHost() const { return cores_; }
+        double memoryPerHost() const { return memory_; }
+        int freeCores(int host) const { return free_[host]; }
+        double freeMemory(int host) const { return free_memory_[host]; }
+
+        bool fits(int host, int cores, double memory) const {
+            return free_[host] >= cores && free_memory_[host] >= memory;
+        }
+
+        // Lowest-numbered unreserved host with at least cores free cores and memory free memory, or -1.
+        int firstFit(int cores, double memory = 0.0) const {
+            return tree_.empty() ? -1 : find(1, cores, memory);
+        }
+
+        // Unreserved host with the fewest free cores that still has enough free cores and memory, or -1.
+        // Hosts are scanned by free core count, from the smallest sufficient count up, and the first one with
+        // enough free memory is returned, so a job can land on a host with more free cores when memory is short.
+        int bestFit(int cores, double memory = 0.0) const {
+            for (int c = std::max(cores, 1); c <= cores_; c++) {
+                const std::vector<int>& bucket = buckets_[c];
+                for (auto it = bucket.rbegin(); it != bucket.rend(); ++it) {
+                    if (free_memory_[*it] >= memory) {
+                        return *it;
+                    }
+                }
+            }
+            return -1;
+        }
+
+        // Unreserved host with the most free cores, or -1 if every host is reserved.
+        int mostFree() const {
+            if (tree_.empty() || hosts_ == reservedCount_) {
+                return -1;
+            }
+            for (int c = cores_; c >= 0; c--) {
+                if (!buckets_[c].empty()) {
+                    return buckets_[c].back();
+                }
+            }
+            return -1;
+        }
+
+        void allocate(int host, int cores, double memory = 0.0) { set(host, free_[host] - cores, free_memory_[host] - memory); }
+        void release(int host, int cores, double memory = 0.0) { set(host, free_[host] + cores, free_memory_[host] + memory); }
+
+        void reserve(int host) {
+            unlink(host);
+            reserved_[host] = true;
+            reservedCount_++;
+            update(host, 0, -1.0);
+        }
+
+        void unreserve(int host) {
+            reserved_[host] = false;
+            reservedCount_--;
+            link(host);
+            update(host, free_[host], free_memory_[host]);
+        }
+
+    private:
+        int find(int n, int cores, double memory) const {
+            if (tree_[n] < cores || tree_memory_[n] < memory) {
+                return -1;
+            }
+            if (n >= size_) {
+                return n - size_;
+            }
+            int left = find(2 * n, cores, memory);
+            return left >= 0 ? left : find(2 * n + 1, cores, memory);
+        }
+
+        void set(int host, int free, double free_memory) {
+            if (!reserved_[host]) {
+                unlink(host);
+            }
+            free_[host] = free;
+            free_memory_[host] = free_memory;
+            if (!reserved_[host]) {
+                link(host);
+                update(host, free, free_memory);
+            }
+        }
+
+        void pull(int n) {
+            tree_[n] = std::max(tree_[2 * n], tree_[2 * n + 1]);
+            tree_memory_[n] = std::max(tree_memory_[2 * n], tree_memory_[2 * n + 1]);
+        }
+
+        void update(int host, int cores, double memory) {
+            int n = size_ + host;
+            tree_[n] = cores;
+            tree_memory_[n] = memory;
+            for (n /= 2; n > 0; n /= 2) {
+                pull(n);
+            }
+        }
+
+        // Removes a host from its bucket in O(1) by moving the last host of the bucket into its place.
+        void unlink(int host) {
+            std::vector<int>& bucket = buckets_[free_[host]];
+            int last = bucket.back();
+            bucket[position_[host]] = last;
+            position_[last] = position_[host];
+            bucket.pop_back();
+        }
+
+        void link(int host) {
+            std::vector<int>& bucket = buckets_[free_[host]];
+            position_[host] = static_cast<int>(bucket.size());
+            bucket.push_back(host);
+        }
+
+        int hosts_ = 0;
+        int cores_ = 0;
+        double memory_ = 0.0;
+        int size_ = 0;
+        int reservedCount_ = 0;
+        std::vector<int> free_;
+        std::vector<double> free_memory_;
+        std::vector<bool> reserved_;
+        std::vector<int> tree_;                  // max free cores of unreserved hosts
+        std::vector<double> tree_memory_;        // max free memory of unreserved hosts (-1 for none)
+        std::vector<std::vector<int>> buckets_;  // unreserved hosts by free cores
+        std::vector<int> position_;              // index of every host in its bucket
+};
@@ -0,0 +1,87 @@
+// Historical PanDA error code sampling shared by the cluster and grid examples.
+#pragma once
+
+#include <nlohmann/json.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Per-site error code counts as read from error_codes.json: site -> (error code -> count).
+// Error code "0" holds the number of successful jobs.
+using ErrorCodeTable = std::map<std::string, std::map<std::string, int>>;
+
+// Reads the historical error code counts for all sites from a JSON file.
+inline ErrorCodeTable loadErrorCodes(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error: Could not open " + path);
+    }
+    nlohmann::json j;
+    file >> j;
+    if (!file) {
+        throw std::runtime_error("Error: Failed to parse " + path);
+    }
+
+    // Convert the JSON data to a dictionary
+    ErrorCodeTable dictionary;
+    for (const auto& [site_name, codes] : j.items()) {
+        for (const auto& [code, count] : codes.items()) {
+            dictionary[site_name][code] = count;
+        }
+    }
+    return dictionary;
+}
+
+// Fraction of the historical jobs of a site that failed, i.e. the weight of all nonzero error codes.
+inline double failureFraction(const std::map<std::string, int>& errorCodes) {
+    long total = 0;
+    long failed = 0;
+    for (const auto& [code, count] : errorCodes) {
+        total += count;
+        if (code != "0") {
+            failed += count;
+        }
+    }
+    return total > 0 ? static_cast<double>(failed) / total : 0.0;
+}
+
+class ErrorCodeGenerator {
+    public:
+        // The constructor initializes the weights and the discrete distribution.
+        ErrorCodeGenerator(const std::map<std::string, int>& errorCodes)
+            : errorCodes_(errorCodes), gen_(std::random_device{}())
+        {
+            // Build the weights vector from the error codes
+            for (const auto& pair : errorCodes_) {
+                weights_.push_back(pair.second);
+            }
+            dist_ = std::discrete_distribution<>(weights_.begin(), weights_.end());
+        }
+        
+        // This function returns the next random error code.
+        int getNextErrorCode() {
+            // Generate a random index based on the weights
+            int randomIndex = dist_(gen_);
+            // Get the corresponding error code from the map.
+            auto it = std::next(errorCodes_.cbegin(), randomIndex);
+            try {
+                // Convert the error code string to int.
+                return std::stoi(it->first);
+            } catch (const std::invalid_argument& e) {
+                std::cout << "Error: '" << it->first << "' is not a valid integer error code." << std::endl;
+                return -1; // or handle the error appropriately
+            }
+        }
+        
+    private:
+        std::map<std::string, int> errorCodes_;
+        std::vector<double> weights_;
+        std::mt19937 gen_;
+        std::discrete_distribution<> dist_;
+    };
@@ -0,0 +1,272 @@
+// Time-varying error rates, shared by the cluster and grid examples.
+//
+// Errors come in bursts: a storage outage drives one error code up for an hour, then the site goes back to
+// normal. A regime rescales the historical error code weights of a site; the active regime follows a Markov
+// chain in simulated time and can be forced for fixed time windows. The model is read from a JSON file (see
+// error_regimes.json):
+//
+//   {
+//       "initial": "normal",
+//       "regimes": {
+//           "normal": {"mean_duration": 36000, "next": {"storage-outage": 1.0}},
+//           "storage-outage": {"mean_duration": 3600, "multipliers": {"1305": 50}, "next": {"normal": 1.0}}
+//       },
+//       "windows": [{"start": 7200, "end": 10800, "regime": "storage-outage"}]
+//   }
+//
+// "multipliers" scale the historical count of an error code (code "0" is success) while the regime is active.
+// A regime stays active for an exponentially distributed time with mean "mean_duration" seconds and then moves
+// to one of the "next" regimes with the given probabilities; without them it is never left. Inside a window
+// the window's regime applies regardless of the chain. Multipliers, durations and transition weights must not
+// be negative, the "next" weights of a regime must not sum to zero, and windows must not be empty or overlap;
+// an invalid model is rejected with the offending regime or window.
+//
+// Every regime has its own precomputed alias table, so a regime change only swaps the active table and a draw
+// costs one random number and one table lookup.
+#pragma once
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Walker/Vose alias table: samples an index with probability proportional to its weight in O(1).
+class AliasTable {
+    public:
+        AliasTable() = default;
+
+        explicit AliasTable(const std::vector<double>& weights) : prob_(weights.size()), alias_(weights.size()) {
+            const size_t n = weights.size();
+            double total = 0.0;
+            for (double w : weights) {
+                total += w;
+            }
+            if (n == 0 || total <= 0) {
+                throw std::runtime_error("Error: Alias table needs a positive total weight");
+            }
+            std::vector<double> scaled(n);
+            std::vector<size_t> small, large;
+            for (size_t i = 0; i < n; i++) {
+                scaled[i] = weights[i] * n / total;
+                (scaled[i] < 1.0 ? small : large).push_back(i);
+            }
+            while (!small.empty() && !large.empty()) {
+                size_t s = small.back();
+                small.pop_back();
+                size_t l = large.back();
+                prob_[s] = scaled[s];
+                alias_[s] = l;
+                scaled[l] -= 1.0 - scaled[s];
+                if (scaled[l] < 1.0) {
+                    large.pop_back();
+                    small.push_back(l);
+                }
+            }
+            // Whatever is left is 1 up to rounding.
+            for (size_t i : large) {
+                prob_[i] = 1.0;
+                alias_[i] = i;
+            }
+            for (size_t i : small) {
+                prob_[i] = 1.0;
+                alias_[i] = i;
+            }
+        }
+
+        template <class Generator>
+        size_t sample(Generator& gen) const {
+            double x = std::uniform_real_distribution<>(0.0, static_cast<double>(prob_.size()))(gen);
+            size_t i = std::min(static_cast<size_t>(x), prob_.size() - 1);
+            return x - i < prob_[i] ? i : alias_[i];
+        }
+
+    private:
+        std::vector<double> prob_;
+        std::vector<size_t> alias_;
+};
+
+// Regime definitions as read from the JSON file; shared by all sites.
+struct ErrorRegimeSpec {
+    struct Regime {
+        std::string name;
+        std::map<std::string, double> multipliers;  // error code -> weight factor
+        double mean_duration = 0.0;                 // 0: the regime is never left
+        std::vector<size_t> next;                   // possible next regimes
+        std::vector<double> next_weights;
+    };
+    struct Window {
+        double start;
+        double end;
+        size_t regime;
+    };
+    std::vector<Regime> regimes;
+    size_t initial = 0;
+    std::vector<Window> windows;  // sorted by start time
+};
+
+inline ErrorRegimeSpec loadErrorRegimes(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error: Could not open " + path);
+    }
+    nlohmann::json j;
+    file >> j;
+    if (!file) {
+        throw std::runtime_error("Error: Failed to parse " + path);
+    }
+
+    ErrorRegimeSpec spec;
+    try {
+        auto check = [](bool ok, const std::string& what) {
+            if (!ok) {
+                throw std::invalid_argument(what);
+            }
+        };
+        std::map<std::string, size_t> index;
+        for (const auto& [name, r] : j.at("regimes").items()) {
+            index[name] = spec.regimes.size();
+            spec.regimes.push_back({name, {}, r.value("mean_duration", 0.0), {}, {}});
+            check(spec.regimes.back().mean_duration >= 0, "regime " + name + ": mean_duration must not be negative");
+            if (r.contains("multipliers")) {
+                for (const auto& [code, factor] : r["multipliers"].items()) {
+                    double multiplier = factor.get<double>();
+                    check(multiplier >= 0 && std::isfinite(multiplier),
+                          "regime " + name + ": multiplier of code " + code + " must be finite and not negative");
+                    spec.regimes.back().multipliers[code] = multiplier;
+                }
+            }
+        }
+        // Transitions can only be resolved once all regime names are known.
+        for (const auto& [name, r] : j.at("regimes").items()) {
+            if (!r.contains("next")) {
+                continue;
+            }
+            ErrorRegimeSpec::Regime& regime = spec.regimes[index.at(name)];
+            double total = 0.0;
+            for (const auto& [next, p] : r["next"].items()) {
+                double weight = p.get<double>();
+                check(weight >= 0 && std::isfinite(weight),
+                      "regime " + name + ": weight of next regime " + next + " must be finite and not negative");
+                regime.next.push_back(index.at(next));
+                regime.next_weights.push_back(weight);
+                total += weight;
+            }
+            check(regime.next.empty() || total > 0, "regime " + name + ": next weights sum to zero");
+        }
+        if (j.contains("initial")) {
+            spec.initial = index.at(j["initial"].get<std::string>());
+        }
+        if (j.contains("windows")) {
+            for (const auto& w : j["windows"]) {
+                spec.windows.push_back({w.at("start").get<double>(), w.at("end").get<double>(),
+                                        index.at(w.at("regime").get<std::string>())});
+            }
+            std::sort(spec.windows.begin(), spec.windows.end(),
+                      [](const ErrorRegimeSpec::Window& a, const ErrorRegimeSpec::Window& b) { return a.start < b.start; });
+            for (size_t i = 0; i < spec.windows.size(); i++) {
+                const ErrorRegimeSpec::Window& w = spec.windows[i];
+                std::ostringstream range;
+                range << "window [" << w.start << ", " << w.end << ")";
+                check(w.start >= 0 && w.end > w.start, range.str() + " must have 0 <= start < end");
+                check(i == 0 || w.start >= spec.windows[i - 1].end, range.str() + " overlaps the window before it");
+            }
+        }
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Error: Invalid error regime model in " + path + ": " + e.what());
+    }
+    if (spec.regimes.empty()) {
+        throw std::runtime_error("Error: No regimes in " + path);
+    }
+    return spec;
+}
+
+// Error code sampler for one site whose weights depend on the active regime. Draws must come with
+// non-decreasing simulated times, as returned by Engine::get_clock().
+class TimeVaryingErrorGenerator {
+    public:
+        TimeVaryingErrorGenerator(const ErrorRegimeSpec& spec, const std::map<std::string, int>& errorCodes)
+            : spec_(spec), gen_(std::random_device{}()), draws_(spec.regimes.size(), 0), failures_(spec.regimes.size(), 0)
+        {
+            // A site without historical data never fails.
+            std::map<std::string, int> counts = errorCodes.empty() ? std::map<std::string, int>{{"0", 1}} : errorCodes;
+            for (const auto& [code, count] : counts) {
+                try {
+                    codes_.push_back(std::stoi(code));
+                } catch (const std::logic_error& e) {
+                    throw std::runtime_error("Error: '" + code + "' is not a valid integer error code.");
+                }
+            }
+            for (const ErrorRegimeSpec::Regime& regime : spec_.regimes) {
+                std::vector<double> weights;
+                for (const auto& [code, count] : counts) {
+                    auto it = regime.multipliers.find(code);
+                    weights.push_back(count * (it != regime.multipliers.end() ? it->second : 1.0));
+                }
+                tables_.emplace_back(weights);
+                transitions_.emplace_back(regime.next_weights.begin(), regime.next_weights.end());
+            }
+            state_ = spec_.initial;
+            next_switch_ = holdingTime(state_);
+        }
+
+        int getNextErrorCode(double now) {
+            size_t regime = regimeAt(now);
+            int code = codes_[tables_[regime].sample(gen_)];
+            draws_[regime]++;
+            if (code != 0) {
+                failures_[regime]++;
+            }
+            return code;
+        }
+
+        const ErrorRegimeSpec& spec() const { return spec_; }
+        long draws(size_t regime) const { return draws_[regime]; }
+        long failures(size_t regime) const { return failures_[regime]; }
+        long switches() const { return switches_; }
+
+    private:
+        double holdingTime(size_t regime) {
+            const ErrorRegimeSpec::Regime& r = spec_.regimes[regime];
+            if (r.mean_duration <= 0 || r.next.empty()) {
+                return std::numeric_limits<double>::infinity();
+            }
+            return std::exponential_distribution<>(1.0 / r.mean_duration)(gen_);
+        }
+
+        // Advances the chain up to now; a window overrides the chain while it lasts.
+        size_t regimeAt(double now) {
+            while (now >= next_switch_) {
+                const ErrorRegimeSpec::Regime& r = spec_.regimes[state_];
+                state_ = r.next[transitions_[state_](gen_)];
+                next_switch_ += holdingTime(state_);
+                switches_++;
+            }
+            while (window_ < spec_.windows.size() && now >= spec_.windows[window_].end) {
+                window_++;
+            }
+            if (window_ < spec_.windows.size() && now >= spec_.windows[window_].start) {
+                return spec_.windows[window_].regime;
+            }
+            return state_;
+        }
+
+        ErrorRegimeSpec spec_;
+        std::mt19937 gen_;
+        std::vector<int> codes_;
+        std::vector<AliasTable> tables_;                            // one per regime
+        std::vector<std::discrete_distribution<>> transitions_;     // next-regime choice per regime
+        size_t state_ = 0;
+        double next_switch_ = 0.0;
+        size_t window_ = 0;
+        long switches_ = 0;
+        std::vector<long> draws_;
+        std::vector<long> failures_;
+};
@@ -0,0 +1,136 @@
+// Per-error-code time-to-failure model, shared by the cluster and grid examples.
+//
+// Decides after how many seconds of running a job fails, given its error code and its total load.
+// The model is read from a JSON file (see failure_timing.json):
+//
+//   {
+//       "default": {"model": "fixed", "seconds": 10},
+//       "codes": {
+//           "1099": {"model": "fraction", "fraction": 0.05},
+//           "1305": {"model": "uniform", "min_fraction": 0.1, "max_fraction": 1.0},
+//           "1150": {"model": "lognormal", "mu": 2.0, "sigma": 0.5}
+//       }
+//   }
+//
+// Models: "fixed" (seconds), "fraction" (of the load), "uniform" (fraction of the load between
+// min_fraction and max_fraction), "lognormal" (seconds, parameters of the underlying normal) and
+// "exponential" (seconds, mean). Fractions lie between 0 and 1, sigma and mean are positive, and
+// an invalid model is rejected with its code. The time to failure never exceeds the load of the job.
+// Without a file, every failure happens after 10 seconds, as in the original slice loop.
+#pragma once
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+class FailureTimingModel {
+    public:
+        FailureTimingModel() : gen_(std::random_device{}()) {}
+
+        // Reads the per-code models from a JSON file.
+        explicit FailureTimingModel(const std::string& path) : FailureTimingModel() {
+            std::ifstream file(path);
+            if (!file.is_open()) {
+                throw std::runtime_error("Error: Could not open " + path);
+            }
+            nlohmann::json j;
+            file >> j;
+            if (!file) {
+                throw std::runtime_error("Error: Failed to parse " + path);
+            }
+            try {
+                if (j.contains("default")) {
+                    default_ = parse("default", j["default"]);
+                }
+                if (j.contains("codes")) {
+                    for (const auto& [code, model] : j["codes"].items()) {
+                        models_[std::stoi(code)] = parse("code " + code, model);
+                    }
+                }
+            } catch (const std::exception& e) {
+                throw std::runtime_error("Error: Invalid failure timing model in " + path + ": " + e.what());
+            }
+        }
+
+        // Seconds a job with the given nonzero error code and load runs before it fails.
+        double timeToFailure(int error_code, double load) {
+            auto it = models_.find(error_code);
+            const Model& m = it != models_.end() ? it->second : default_;
+            double t;
+            switch (m.kind) {
+                case Kind::Fixed:
+                    t = m.a;
+                    break;
+                case Kind::Fraction:
+                    t = m.a * load;
+                    break;
+                case Kind::Uniform:
+                    t = std::uniform_real_distribution<>(m.a, m.b)(gen_) * load;
+                    break;
+                case Kind::LogNormal:
+                    t = std::lognormal_distribution<>(m.a, m.b)(gen_);
+                    break;
+                case Kind::Exponential:
+                    t = std::exponential_distribution<>(1.0 / m.a)(gen_);
+                    break;
+                default:
+                    t = load;
+            }
+            return std::clamp(t, 0.0, load);
+        }
+
+    private:
+        enum class Kind { Fixed, Fraction, Uniform, LogNormal, Exponential };
+
+        struct Model {
+            Kind kind;
+            double a;
+            double b;
+        };
+
+        // Parses and validates the model of one code (or the default), named in the error messages.
+        static Model parse(const std::string& name, const nlohmann::json& m) {
+            std::string kind = m.at("model").get<std::string>();
+            auto check = [&name](bool ok, const std::string& parameter) {
+                if (!ok) {
+                    throw std::invalid_argument(name + ": invalid " + parameter);
+                }
+            };
+            if (kind == "fixed") {
+                Model model{Kind::Fixed, m.at("seconds").get<double>(), 0.0};
+                check(model.a >= 0, "seconds (must not be negative)");
+                return model;
+            }
+            if (kind == "fraction") {
+                Model model{Kind::Fraction, m.at("fraction").get<double>(), 0.0};
+                check(model.a >= 0 && model.a <= 1, "fraction (must be between 0 and 1)");
+                return model;
+            }
+            if (kind == "uniform") {
+                Model model{Kind::Uniform, m.at("min_fraction").get<double>(), m.at("max_fraction").get<double>()};
+                check(model.a >= 0 && model.a <= model.b && model.b <= 1,
+                      "min_fraction/max_fraction (need 0 <= min_fraction <= max_fraction <= 1)");
+                return model;
+            }
+            if (kind == "lognormal") {
+                Model model{Kind::LogNormal, m.at("mu").get<double>(), m.at("sigma").get<double>()};
+                check(model.b > 0, "sigma (must be positive)");
+                return model;
+            }
+            if (kind == "exponential") {
+                Model model{Kind::Exponential, m.at("mean").get<double>(), 0.0};
+                check(model.a > 0, "mean (must be positive)");
+                return model;
+            }
+            throw std::invalid_argument(name + ": unknown failure timing model " + kind);
+        }
+
+        Model default_ = {Kind::Fixed, 10.0, 0.0};
+        std::unordered_map<int, Model> models_;
+        std::mt19937 gen_;
+};
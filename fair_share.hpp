@@ -0,0 +1,140 @@
+// Fair-share selection among job groups (cluster example).
+//
+// Every group has a share target. The usage charged to a group decays exponentially with a half-life, and its
+// effective priority is its usage divided by its share: the active group with the lowest value gets the next job.
+// Decay scales the usage of all groups by the same factor, so it never changes their order. Usage is therefore
+// stored inflated by the decay since a reference time: charging a group only moves that group in an indexed binary
+// heap, in O(log groups), and nothing has to be recomputed as simulated time passes. Before the inflation factor
+// could overflow, all groups are rescaled once and the reference time moves forward.
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+class FairShare {
+    public:
+        FairShare() = default;
+
+        // half_life is in seconds; 0 keeps all usage forever.
+        FairShare(std::vector<double> shares, double half_life)
+            : share_(std::move(shares)), usage_(share_.size(), 0.0), position_(share_.size(), -1),
+              decay_(half_life > 0 ? std::log(2.0) / half_life : 0.0)
+        {
+            for (double share : share_) {
+                if (share <= 0) {
+                    throw std::runtime_error("Error: Fair-share targets must be positive");
+                }
+            }
+        }
+
+        size_t groups() const { return share_.size(); }
+        bool empty() const { return heap_.empty(); }
+
+        // Active group with the lowest effective priority; only groups with waiting jobs are active.
+        int top() const { return heap_.front(); }
+
+        void activate(int group) {
+            if (position_[group] >= 0) {
+                return;
+            }
+            position_[group] = static_cast<int>(heap_.size());
+            heap_.push_back(group);
+            siftUp(position_[group]);
+        }
+
+        void deactivate(int group) {
+            int i = position_[group];
+            if (i < 0) {
+                return;
+            }
+            int last = heap_.back();
+            heap_.pop_back();
+            position_[group] = -1;
+            if (last != group) {
+                heap_[i] = last;
+                position_[last] = i;
+                siftDown(i);
+                siftUp(position_[last]);
+            }
+        }
+
+        // Adds usage (e.g. CPU seconds) to a group at simulated time now; a negative amount corrects an earlier
+        // estimate. Times must not decrease.
+        void charge(int group, double amount, double now) {
+            if (decay_ * (now - reference_) > MAX_EXPONENT) {
+                rebase(now);
+            }
+            usage_[group] = std::max(0.0, usage_[group] + amount * std::exp(decay_ * (now - reference_)));
+            int i = position_[group];
+            if (i >= 0) {
+                siftDown(i);
+                siftUp(position_[group]);
+            }
+        }
+
+        // Decayed usage of a group at simulated time now.
+        double usage(int group, double now) const {
+            return usage_[group] * std::exp(-decay_ * (now - reference_));
+        }
+
+        double share(int group) const { return share_[group]; }
+
+    private:
+        static constexpr double MAX_EXPONENT = 500.0;
+
+        // Ties go to the lower group index, so the order is deterministic.
+        bool before(int a, int b) const {
+            double pa = usage_[a] / share_[a];
+            double pb = usage_[b] / share_[b];
+            return pa < pb || (pa == pb && a < b);
+        }
+
+        void swap(int i, int j) {
+            std::swap(heap_[i], heap_[j]);
+            position_[heap_[i]] = i;
+            position_[heap_[j]] = j;
+        }
+
+        void siftUp(int i) {
+            while (i > 0 && before(heap_[i], heap_[(i - 1) / 2])) {
+                swap(i, (i - 1) / 2);
+                i = (i - 1) / 2;
+            }
+        }
+
+        void siftDown(int i) {
+            const int n = static_cast<int>(heap_.size());
+            while (true) {
+                int best = i;
+                for (int child = 2 * i + 1; child <= 2 * i + 2 && child < n; child++) {
+                    if (before(heap_[child], heap_[best])) {
+                        best = child;
+                    }
+                }
+                if (best == i) {
+                    return;
+                }
+                swap(i, best);
+                i = best;
+            }
+        }
+
+        // Scales all usage to a new reference time; the order of the groups stays the same.
+        void rebase(double now) {
+            double factor = std::exp(-decay_ * (now - reference_));
+            for (double& u : usage_) {
+                u *= factor;
+            }
+            reference_ = now;
+        }
+
+        std::vector<double> share_;
+        std::vector<double> usage_;   // inflated by exp(decay * (t - reference)) at charge time t
+        std::vector<int> heap_;       // active groups, lowest usage per share first
+        std::vector<int> position_;   // index of every group in heap_, -1 if inactive
+        double decay_ = 0.0;
+        double reference_ = 0.0;
+};
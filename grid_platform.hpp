@@ -0,0 +1,216 @@
+// Generated multi-site grid platform for the grid example.
+//
+// Every PanDA queue from error_codes.json becomes its own star-routed cluster zone, sized from a
+// site catalog (site_catalog.json). The site zones hang off a top-level star zone that acts as the
+// WAN backbone: each site reaches the backbone through one WAN link with its own bandwidth and
+// latency. Routing is hierarchical, so route tables stay linear in the number of hosts and sites
+// even with hundreds of zones and tens of thousands of hosts.
+//
+// Every worker host has a local scratch disk, and every site has a storage element: a host with one
+// shared disk, attached to the site backbone through its own link. Stage-in and stage-out stream data
+// between the two disks, so their bandwidth is limited by the storage element disk, its link and the
+// scratch disks alike.
+#pragma once
+
+#include <simgrid/s4u.hpp>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "error_code_generator.hpp"
+
+// Description of one site, resolved from the catalog.
+struct SiteSpec {
+    std::string name;
+    int hosts;
+    int cores;                       // cores per host
+    double memory_per_core;          // host memory in MB per core
+    std::string speed;               // per-core speed, e.g. "1Gf"
+    std::string lan_bandwidth;       // host uplink inside the site
+    std::string lan_latency;
+    std::string backbone_bandwidth;  // shared site backbone
+    std::string wan_bandwidth;       // site uplink to the WAN backbone
+    std::string wan_latency;
+    std::string region;
+    std::string se_bandwidth;             // link of the storage element to the site backbone
+    std::string se_read_bandwidth;        // storage element disk, shared by all jobs of the site
+    std::string se_write_bandwidth;
+    std::string scratch_read_bandwidth;   // local scratch disk of every worker host
+    std::string scratch_write_bandwidth;
+};
+
+// Resolves a SiteSpec for every site of the error table that is not excluded by the catalog.
+// Site properties come from (in order of precedence) the "sites" entry, its region and the "defaults".
+// The region is the one named by the "region" field of the "sites" entry ("default" for none), or else
+// the one "regions" entry with a "match" pattern that is a prefix of the site name (ignoring the
+// "ANALY_" prefix of analysis queues). A site that matches no region, or more than one, is an error. Without an explicit host count, a site gets one host per
+// "jobs_per_host" historical jobs, clamped to [min_hosts, max_hosts]. All host counts are then
+// multiplied by scale. If only is not empty, only the listed sites are kept.
+inline std::vector<SiteSpec> loadSiteSpecs(const std::string& catalog_path, const ErrorCodeTable& errors,
+                                           double scale = 1.0, const std::set<std::string>& only = {}) {
+    std::ifstream file(catalog_path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error: Could not open " + catalog_path);
+    }
+    nlohmann::json catalog;
+    file >> catalog;
+    if (!file) {
+        throw std::runtime_error("Error: Failed to parse " + catalog_path);
+    }
+
+    const nlohmann::json& defaults = catalog.at("defaults");
+    std::set<std::string> exclude;
+    if (catalog.contains("exclude")) {
+        exclude = catalog["exclude"].get<std::set<std::string>>();
+    }
+    const nlohmann::json regions = catalog.value("regions", nlohmann::json::array());
+    const nlohmann::json sites = catalog.value("sites", nlohmann::json::object());
+
+    std::vector<SiteSpec> specs;
+    for (const auto& [site_name, codes] : errors) {
+        if (exclude.count(site_name) > 0 || (!only.empty() && only.count(site_name) == 0)) {
+            continue;
+        }
+
+        // Layer the catalog entries: defaults, then region, then the site itself.
+        nlohmann::json entry = defaults;
+        const nlohmann::json site = sites.value(site_name, nlohmann::json::object());
+        std::string region;
+        const nlohmann::json* region_entry = nullptr;
+        if (site.contains("region")) {
+            region = site["region"].get<std::string>();
+            for (const auto& r : regions) {
+                if (r.at("name").get<std::string>() == region) {
+                    region_entry = &r;
+                }
+            }
+            if (region_entry == nullptr && region != "default") {
+                throw std::runtime_error("Error: Site " + site_name + " names unknown region " + region + " in " +
+                                         catalog_path);
+            }
+        } else {
+            std::string_view name = site_name;
+            if (name.substr(0, 6) == "ANALY_") {
+                name.remove_prefix(6);
+            }
+            for (const auto& r : regions) {
+                const auto& patterns = r.at("match");
+                bool matched = std::any_of(patterns.begin(), patterns.end(), [name](const nlohmann::json& p) {
+                    const auto& prefix = p.get_ref<const std::string&>();
+                    return name.substr(0, prefix.size()) == prefix;
+                });
+                if (!matched) {
+                    continue;
+                }
+                if (region_entry != nullptr) {
+                    throw std::runtime_error("Error: Site " + site_name + " matches regions " + region + " and " +
+                                             r.at("name").get<std::string>() + " in " + catalog_path);
+                }
+                region_entry = &r;
+                region = r.at("name").get<std::string>();
+            }
+            if (region_entry == nullptr) {
+                throw std::runtime_error("Error: Site " + site_name + " matches no region in " + catalog_path +
+                                         " (add a \"region\" to its \"sites\" entry)");
+            }
+        }
+        if (region_entry != nullptr) {
+            entry.update(*region_entry);
+        }
+        entry.update(site);
+
+        int hosts;
+        if (entry.contains("hosts")) {
+            hosts = entry["hosts"].get<int>();
+        } else {
+            long total_jobs = 0;
+            for (const auto& [code, count] : codes) {
+                total_jobs += count;
+            }
+            hosts = static_cast<int>(std::lround(static_cast<double>(total_jobs) / entry.at("jobs_per_host").get<double>()));
+            hosts = std::clamp(hosts, entry.at("min_hosts").get<int>(), entry.at("max_hosts").get<int>());
+        }
+        hosts = std::max(1, static_cast<int>(std::lround(hosts * scale)));
+
+        specs.push_back({site_name, hosts, entry.value("cores", 1), entry.value("memory_per_core", 2000.0),
+                         entry.at("speed").get<std::string>(),
+                         entry.at("lan_bandwidth").get<std::string>(), entry.at("lan_latency").get<std::string>(),
+                         entry.at("backbone_bandwidth").get<std::string>(),
+                         entry.at("wan_bandwidth").get<std::string>(), entry.at("wan_latency").get<std::string>(),
+                         region,
+                         entry.value("se_bandwidth", std::string("40Gbps")),
+                         entry.value("se_read_bandwidth", std::string("2GBps")),
+                         entry.value("se_write_bandwidth", std::string("1GBps")),
+                         entry.value("scratch_read_bandwidth", std::string("500MBps")),
+                         entry.value("scratch_write_bandwidth", std::string("300MBps"))});
+    }
+    return specs;
+}
+
+// Handles to the generated platform: the central PanDA server, the hosts and the storage element of every
+// site (in the same order as the SiteSpec vector). Every worker host has one disk, its scratch space.
+struct GridPlatform {
+    simgrid::s4u::Host* server = nullptr;
+    std::vector<std::vector<simgrid::s4u::Host*>> site_hosts;
+    std::vector<simgrid::s4u::Host*> site_storage;
+    std::vector<simgrid::s4u::Disk*> site_storage_disks;
+};
+
+// Builds the platform. Must be called after the Engine is created and instead of load_platform().
+inline GridPlatform createGridPlatform(const std::vector<SiteSpec>& specs) {
+    namespace sg4 = simgrid::s4u;
+
+    GridPlatform platform;
+    auto* grid = sg4::create_star_zone("grid");
+
+    // The PanDA server sits next to the backbone (at CERN).
+    platform.server = grid->create_host("panda-server", "10Gf");
+    const sg4::Link* server_link = grid->create_link("panda-server-wan", "100Gbps")->set_latency("1ms")->seal();
+    grid->add_route(platform.server->get_netpoint(), nullptr, nullptr, nullptr, {server_link}, true);
+
+    for (const SiteSpec& spec : specs) {
+        auto* site = sg4::create_star_zone(spec.name);
+        site->set_parent(grid);
+
+        // All hosts of the site share the site backbone, each through its own full-duplex uplink.
+        const sg4::Link* backbone = site->create_link(spec.name + "-backbone", spec.backbone_bandwidth)->set_latency(spec.lan_latency)->seal();
+        std::vector<sg4::Host*> hosts;
+        hosts.reserve(spec.hosts);
+        for (int i = 0; i < spec.hosts; i++) {
+            std::string host_name = spec.name + "-" + std::to_string(i);
+            sg4::Host* host = site->create_host(host_name, spec.speed)->set_core_count(spec.cores);
+            host->create_disk("scratch", spec.scratch_read_bandwidth, spec.scratch_write_bandwidth)->seal();
+            const sg4::Link* uplink = site->create_split_duplex_link(host_name + "-uplink", spec.lan_bandwidth)->set_latency(spec.lan_latency)->seal();
+            site->add_route(host->get_netpoint(), nullptr, nullptr, nullptr,
+                            {{uplink, sg4::LinkInRoute::Direction::UP}, backbone}, true);
+            hosts.push_back(host);
+        }
+
+        // The storage element serves all hosts of the site through one disk.
+        sg4::Host* storage = site->create_host(spec.name + "-se", spec.speed);
+        sg4::Disk* storage_disk = storage->create_disk("storage", spec.se_read_bandwidth, spec.se_write_bandwidth)->seal();
+        const sg4::Link* storage_link = site->create_link(spec.name + "-se-link", spec.se_bandwidth)->set_latency(spec.lan_latency)->seal();
+        site->add_route(storage->get_netpoint(), nullptr, nullptr, nullptr, {storage_link, backbone}, true);
+
+        auto* gateway = site->create_router(spec.name + "-gw");
+        site->set_gateway(gateway);
+        site->seal();
+
+        // One WAN link connects the site gateway to the backbone.
+        const sg4::Link* wan = grid->create_link(spec.name + "-wan", spec.wan_bandwidth)->set_latency(spec.wan_latency)->seal();
+        grid->add_route(site->get_netpoint(), nullptr, gateway, nullptr, {wan}, true);
+
+        platform.site_hosts.push_back(std::move(hosts));
+        platform.site_storage.push_back(storage);
+        platform.site_storage_disks.push_back(storage_disk);
+    }
+    grid->seal();
+    return platform;
+}
@@ -0,0 +1,158 @@
+// Job dependency DAGs for task workloads (cluster example).
+//
+// A task is a chain of stages such as evgen -> simul -> reco -> merge, each with a number of jobs. A job becomes ready
+// once all of its parents have succeeded; a job whose parent has failed for good is cancelled with all of its
+// descendants. Every job keeps a counter of the parents that have not succeeded yet, and the children are stored
+// in one compressed array (CSR), so a finished job only touches its own children and readiness never needs a
+// rescan, even for DAGs with millions of jobs.
+#pragma once
+
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct DagStage {
+    std::string name;
+    int jobs = 1;
+    double load_factor = 1.0;  // scales the job length of the stage
+};
+
+// Parses "stage[:jobs[:load factor]],...", e.g. "evgen:10,simul:10:4,reco:10:2,merge:1".
+inline std::vector<DagStage> parseTaskChain(const std::string& text) {
+    std::vector<DagStage> stages;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) {
+            continue;
+        }
+        std::stringstream fields(item);
+        DagStage stage;
+        std::string jobs, factor;
+        std::getline(fields, stage.name, ':');
+        std::getline(fields, jobs, ':');
+        std::getline(fields, factor, ':');
+        try {
+            if (!jobs.empty()) {
+                stage.jobs = std::stoi(jobs);
+            }
+            if (!factor.empty()) {
+                stage.load_factor = std::stod(factor);
+            }
+        } catch (const std::logic_error&) {
+            throw std::runtime_error("Error: Invalid stage in --task-chain: " + item);
+        }
+        if (stage.name.empty() || stage.jobs < 1 || stage.load_factor <= 0) {
+            throw std::runtime_error("Error: Invalid stage in --task-chain: " + item);
+        }
+        stages.push_back(stage);
+    }
+    if (stages.empty()) {
+        throw std::runtime_error("Error: --task-chain needs at least one stage");
+    }
+    return stages;
+}
+
+class JobDag {
+    public:
+        JobDag() = default;
+
+        // Builds the given number of identical task chains. Jobs are numbered task by task and stage by stage.
+        // Between two stages of the same size, every job depends on one job of the previous stage; a smaller stage
+        // merges contiguous blocks of the previous stage, and a larger one splits every job of the previous stage
+        // into several.
+        JobDag(const std::vector<DagStage>& stages, long tasks) : stages_(stages) {
+            for (const DagStage& stage : stages_) {
+                stage_first_.push_back(jobs_per_task_);
+                jobs_per_task_ += stage.jobs;
+            }
+            const long nodes = jobs_per_task_ * tasks;
+            waiting_.assign(nodes, 0);
+            cancelled_.assign(nodes, false);
+            child_offset_.reserve(nodes + 1);
+            child_offset_.push_back(0);
+            for (long t = 0; t < tasks; t++) {
+                const long base = t * jobs_per_task_;
+                for (size_t s = 0; s < stages_.size(); s++) {
+                    for (int j = 0; j < stages_[s].jobs; j++) {
+                        if (s + 1 < stages_.size()) {
+                            const int next = stages_[s + 1].jobs;
+                            const int cur = stages_[s].jobs;
+                            // The children of job j: a block of the next stage, or the one job merging its block.
+                            int first = static_cast<int>(static_cast<long>(j) * next / cur);
+                            int last = next >= cur ? static_cast<int>(static_cast<long>(j + 1) * next / cur) : first + 1;
+                            for (int c = first; c < last; c++) {
+                                long child = base + stage_first_[s + 1] + c;
+                                children_.push_back(child);
+                                waiting_[child]++;
+                            }
+                        }
+                        child_offset_.push_back(static_cast<int64_t>(children_.size()));
+                    }
+                }
+            }
+        }
+
+        long nodes() const { return static_cast<long>(waiting_.size()); }
+        long jobsPerTask() const { return jobs_per_task_; }
+        long tasks() const { return jobs_per_task_ > 0 ? nodes() / jobs_per_task_ : 0; }
+        long task(long node) const { return node / jobs_per_task_; }
+        const std::vector<DagStage>& stages() const { return stages_; }
+
+        const DagStage& stage(long node) const {
+            long offset = node % jobs_per_task_;
+            size_t s = stages_.size() - 1;
+            while (stage_first_[s] > offset) {
+                s--;
+            }
+            return stages_[s];
+        }
+
+        // Jobs of a task without parents, i.e. the jobs of its first stage.
+        std::vector<long> roots(long task) const {
+            std::vector<long> roots;
+            for (int j = 0; j < stages_.front().jobs; j++) {
+                roots.push_back(task * jobs_per_task_ + j);
+            }
+            return roots;
+        }
+
+        // Marks a job as succeeded and appends the children that have become ready to ready.
+        void succeed(long node, std::vector<long>& ready) {
+            for (int64_t i = child_offset_[node]; i < child_offset_[node + 1]; i++) {
+                long child = children_[i];
+                if (--waiting_[child] == 0) {
+                    ready.push_back(child);
+                }
+            }
+        }
+
+        // Cancels the descendants of a job that has failed for good and appends each of them to cancelled once. None
+        // of them has started, since they all wait for the failed job.
+        void cancelDescendants(long node, std::vector<long>& cancelled) {
+            std::vector<long> stack{node};
+            while (!stack.empty()) {
+                long n = stack.back();
+                stack.pop_back();
+                for (int64_t i = child_offset_[n]; i < child_offset_[n + 1]; i++) {
+                    long child = children_[i];
+                    if (!cancelled_[child]) {
+                        cancelled_[child] = true;
+                        cancelled.push_back(child);
+                        stack.push_back(child);
+                    }
+                }
+            }
+        }
+
+    private:
+        std::vector<DagStage> stages_;
+        std::vector<long> stage_first_;    // offset of the first job of every stage within a task
+        long jobs_per_task_ = 0;
+        std::vector<int> waiting_;         // parents that have not succeeded yet, per job
+        std::vector<bool> cancelled_;
+        std::vector<int64_t> child_offset_;  // children of job n are children_[child_offset_[n] .. child_offset_[n + 1])
+        std::vector<long> children_;
+};
@@ -0,0 +1,140 @@
+// Binary per-job event log shared by the simulators and job_event_log_decoder.
+//
+// Every event is a fixed-size JobEventRecord. Records are appended to an in-memory buffer and
+// written out with a single fwrite() whenever the buffer is full (and on close), so recording an
+// event costs a couple of stores instead of a formatted log line.
+//
+// File layout: a 16-byte JobEventLogHeader followed by JobEventRecord entries in host byte order.
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Event types stored in JobEventRecord::event.
+enum class JobEvent : uint8_t {
+    Dispatched = 0,  // master or resubmitter started handing the job out (worker -1; see Started for the worker)
+    Started = 1,     // worker started processing the job
+    Succeeded = 2,   // job finished with error code 0
+    Failed = 3,      // job finished with a nonzero error code
+    Aborted = 4,     // failed job was aborted before completing its load
+    Retried = 5,     // failed job was handed back for resubmission
+    Lost = 6,        // job was lost with the host it was running on
+};
+
+inline const char* jobEventName(uint8_t event) {
+    switch (static_cast<JobEvent>(event)) {
+        case JobEvent::Dispatched: return "dispatched";
+        case JobEvent::Started:    return "started";
+        case JobEvent::Succeeded:  return "succeeded";
+        case JobEvent::Failed:     return "failed";
+        case JobEvent::Aborted:    return "aborted";
+        case JobEvent::Retried:    return "retried";
+        case JobEvent::Lost:       return "lost";
+    }
+    return "unknown";
+}
+
+struct JobEventRecord {
+    uint64_t job_id;
+    double sim_time;     // simulated time of the event in seconds
+    int32_t worker;      // worker index, -1 if not applicable
+    int32_t error_code;  // 0 unless the event is Failed, Aborted or Retried
+    uint8_t event;       // a JobEvent value
+    uint8_t reserved[7];
+};
+static_assert(sizeof(JobEventRecord) == 32, "JobEventRecord must stay 32 bytes");
+
+struct JobEventLogHeader {
+    char magic[8];          // "JOBEVLOG"
+    uint32_t version;
+    uint32_t record_size;   // sizeof(JobEventRecord) of the writer
+};
+static_assert(sizeof(JobEventLogHeader) == 16, "JobEventLogHeader must stay 16 bytes");
+
+constexpr char kJobEventLogMagic[8] = {'J', 'O', 'B', 'E', 'V', 'L', 'O', 'G'};
+constexpr uint32_t kJobEventLogVersion = 1;
+
+class JobEventLog {
+    public:
+        // Opens (truncates) the log file. capacity is the number of records buffered between writes.
+        explicit JobEventLog(const std::string& path, size_t capacity = 1 << 16)
+            : file_(std::fopen(path.c_str(), "wb")), buffer_(capacity), size_(0)
+        {
+            if (file_ == nullptr) {
+                throw std::runtime_error("Error: Could not open event log " + path);
+            }
+            JobEventLogHeader header{};
+            std::memcpy(header.magic, kJobEventLogMagic, sizeof(header.magic));
+            header.version = kJobEventLogVersion;
+            header.record_size = sizeof(JobEventRecord);
+            write(&header, sizeof(header));
+        }
+
+        // A destructor must not throw, so a failed final write is only reported; call close() to handle it.
+        ~JobEventLog() {
+            try {
+                close();
+            } catch (const std::exception& e) {
+                std::fprintf(stderr, "%s\n", e.what());
+            }
+        }
+
+        JobEventLog(const JobEventLog&) = delete;
+        JobEventLog& operator=(const JobEventLog&) = delete;
+
+        // Appends one record; only touches the disk when the buffer is full.
+        void record(uint64_t job_id, int worker, JobEvent event, double sim_time, int error_code = 0) {
+            if (size_ == buffer_.size()) {
+                flush();
+            }
+            JobEventRecord& r = buffer_[size_++];
+            r.job_id = job_id;
+            r.sim_time = sim_time;
+            r.worker = worker;
+            r.error_code = error_code;
+            r.event = static_cast<uint8_t>(event);
+            std::memset(r.reserved, 0, sizeof(r.reserved));
+        }
+
+        // Writes all buffered records in one sequential write.
+        void flush() {
+            if (size_ > 0) {
+                write(buffer_.data(), size_ * sizeof(JobEventRecord));
+                size_ = 0;
+            }
+        }
+
+        // Writes the remaining records and closes the file, which is closed even if the write fails.
+        void close() {
+            if (file_ == nullptr) {
+                return;
+            }
+            bool written = true;
+            try {
+                flush();
+            } catch (const std::runtime_error&) {
+                written = false;
+                size_ = 0;
+            }
+            written = std::fclose(file_) == 0 && written;
+            file_ = nullptr;
+            if (!written) {
+                throw std::runtime_error("Error: Failed to write event log");
+            }
+        }
+
+    private:
+        void write(const void* data, size_t bytes) {
+            if (std::fwrite(data, 1, bytes, file_) != bytes) {
+                throw std::runtime_error("Error: Failed to write event log");
+            }
+        }
+
+        std::FILE* file_;
+        std::vector<JobEventRecord> buffer_;
+        size_t size_;
+};
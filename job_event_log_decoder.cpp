@@ -0,0 +1,87 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "job_event_log.hpp"
+
+using namespace std;
+
+// Converts a binary job event log written with --event-log into CSV.
+// The log is read in large chunks, so the file is never loaded as a whole.
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 3) {
+        cerr << "Usage: " << argv[0] << " <event log> [output csv]\n";
+        return 1;
+    }
+
+    FILE* in = fopen(argv[1], "rb");
+    if (in == nullptr) {
+        cerr << "Error: Could not open " << argv[1] << ": " << strerror(errno) << endl;
+        return EXIT_FAILURE;
+    }
+    FILE* out = argc == 3 ? fopen(argv[2], "w") : stdout;
+    if (out == nullptr) {
+        cerr << "Error: Could not open " << argv[2] << ": " << strerror(errno) << endl;
+        fclose(in);
+        return EXIT_FAILURE;
+    }
+
+    // Closes both files on every exit; a failed write of the CSV fails the run.
+    auto finish = [&](int status) {
+        fclose(in);
+        if (ferror(out) || (out != stdout && fclose(out) != 0)) {
+            cerr << "Error: Failed to write " << (out == stdout ? "standard output" : argv[2]) << endl;
+            status = EXIT_FAILURE;
+        }
+        return status;
+    };
+
+    JobEventLogHeader header;
+    if (fread(&header, sizeof(header), 1, in) != 1 ||
+        memcmp(header.magic, kJobEventLogMagic, sizeof(header.magic)) != 0) {
+        cerr << "Error: " << argv[1] << " is not a job event log" << endl;
+        return finish(EXIT_FAILURE);
+    }
+    if (header.version != kJobEventLogVersion || header.record_size != sizeof(JobEventRecord)) {
+        cerr << "Error: Unsupported event log version " << header.version
+             << " (record size " << header.record_size << ")" << endl;
+        return finish(EXIT_FAILURE);
+    }
+
+    fprintf(out, "job_id,worker,event,sim_time,error_code\n");
+    // The chunk is read as bytes, so that a trailing partial record is noticed instead of silently dropped.
+    vector<JobEventRecord> chunk(1 << 16);
+    char* bytes = reinterpret_cast<char*>(chunk.data());
+    const size_t chunk_bytes = chunk.size() * sizeof(JobEventRecord);
+    size_t total = 0;
+    size_t pending = 0;  // bytes of an incomplete record carried over to the next read
+    size_t n;
+    while ((n = fread(bytes + pending, 1, chunk_bytes - pending, in)) > 0) {
+        pending += n;
+        size_t records = pending / sizeof(JobEventRecord);
+        for (size_t i = 0; i < records; i++) {
+            const JobEventRecord& r = chunk[i];
+            fprintf(out, "%llu,%d,%s,%.6f,%d\n", static_cast<unsigned long long>(r.job_id), r.worker,
+                    jobEventName(r.event), r.sim_time, r.error_code);
+        }
+        total += records;
+        pending -= records * sizeof(JobEventRecord);
+        memmove(bytes, bytes + records * sizeof(JobEventRecord), pending);
+    }
+    if (ferror(in)) {
+        cerr << "Error: Failed to read " << argv[1] << endl;
+        return finish(EXIT_FAILURE);
+    }
+    if (pending > 0) {
+        cerr << "Error: " << argv[1] << " ends with a truncated record of " << pending << " bytes after "
+             << total << " records" << endl;
+        return finish(EXIT_FAILURE);
+    }
+
+    cerr << "Decoded " << total << " records" << endl;
+    return finish(0);
+}
@@ -0,0 +1,231 @@
+// Job length (load) models, shared by the cluster and grid examples.
+//
+// A model is given as "<kind>:<parameters>":
+//
+//   uniform:<min>,<max>        uniform between min and max seconds, 0 <= min <= max (the default is uniform:1,15)
+//   lognormal:<mu>,<sigma>     lognormal, mu and sigma of the underlying normal (log-seconds)
+//   weibull:<shape>,<scale>    Weibull with the given positive shape and scale (seconds)
+//   empirical:<file>           histogram read from a CSV file with "lower,upper,count" lines;
+//                              a bin is drawn by its count and the length uniformly within the bin
+//   <value>                    always the same value
+//
+// The same models are used for other per-job quantities, such as the file sizes of data staging, which
+// are sampled with a minimum of 0 so that a size of 0 means no transfer.
+//
+// Per-queue models are read from a JSON file (see job_lengths.json):
+//
+//   {"default": "uniform:1,15", "queues": {"BNL": "lognormal:1.5,0.9", ...}}
+//
+// Samples are generated in batches: refilling a whole buffer in one tight loop keeps the cost per
+// job to a load from memory, even at 1e8 jobs.
+#pragma once
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct JobLengthSpec {
+    enum class Kind { Uniform, LogNormal, Weibull, Empirical };
+    Kind kind = Kind::Uniform;
+    double a = 1.0;
+    double b = 15.0;
+    std::vector<double> lower;       // empirical: lower bin edges
+    std::vector<double> upper;       // empirical: upper bin edges
+    std::vector<double> cumulative;  // empirical: cumulative bin counts
+};
+
+// Reads an empirical job length histogram from a CSV file with "lower,upper,count" lines.
+// Empty lines and lines starting with '#' or a letter (a header) are skipped.
+inline void loadJobLengthHistogram(const std::string& path, JobLengthSpec& spec) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Error: Could not open " + path);
+    }
+    std::string line;
+    double total = 0.0;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#' || std::isalpha(static_cast<unsigned char>(line[0]))) {
+            continue;
+        }
+        std::stringstream ss(line);
+        double lower, upper, count;
+        char sep1, sep2;
+        if (!(ss >> lower >> sep1 >> upper >> sep2 >> count) || upper < lower || count < 0) {
+            throw std::runtime_error("Error: Invalid histogram line in " + path + ": " + line);
+        }
+        total += count;
+        spec.lower.push_back(lower);
+        spec.upper.push_back(upper);
+        spec.cumulative.push_back(total);
+    }
+    if (total <= 0) {
+        throw std::runtime_error("Error: Empty job length histogram " + path);
+    }
+}
+
+// Parses a "<kind>:<parameters>" job length model.
+inline JobLengthSpec parseJobLengthSpec(const std::string& text) {
+    JobLengthSpec spec;
+    auto colon = text.find(':');
+    std::string kind = text.substr(0, colon);
+    std::string params = colon == std::string::npos ? "" : text.substr(colon + 1);
+    if (colon == std::string::npos) {
+        // A plain number is a fixed value.
+        try {
+            size_t end;
+            spec.a = spec.b = std::stod(text, &end);
+            if (end == text.size() && spec.a >= 0) {
+                return spec;
+            }
+        } catch (const std::logic_error&) {
+        }
+        throw std::runtime_error("Error: Invalid job length model '" + text + "'");
+    }
+    if (kind == "empirical") {
+        spec.kind = JobLengthSpec::Kind::Empirical;
+        loadJobLengthHistogram(params, spec);
+        return spec;
+    }
+
+    std::stringstream ss(params);
+    char sep;
+    if (!(ss >> spec.a >> sep >> spec.b) || sep != ',') {
+        throw std::runtime_error("Error: Invalid job length model '" + text + "'");
+    }
+    if (kind == "uniform") {
+        spec.kind = JobLengthSpec::Kind::Uniform;
+        // Lengths and the file sizes parsed with the same models are never negative.
+        if (spec.a < 0 || spec.b < spec.a) {
+            throw std::runtime_error("Error: Invalid job length model '" + text + "'");
+        }
+    } else if (kind == "lognormal") {
+        spec.kind = JobLengthSpec::Kind::LogNormal;
+    } else if (kind == "weibull") {
+        spec.kind = JobLengthSpec::Kind::Weibull;
+        if (spec.a <= 0) {
+            throw std::runtime_error("Error: Invalid job length model '" + text + "' (the Weibull shape must be positive)");
+        }
+    } else {
+        throw std::runtime_error("Error: Unknown job length model '" + kind + "' (expected uniform, lognormal, weibull or empirical)");
+    }
+    if (spec.kind != JobLengthSpec::Kind::Uniform && spec.b <= 0) {
+        throw std::runtime_error("Error: Invalid job length model '" + text + "'");
+    }
+    return spec;
+}
+
+// Draws job lengths from a model, one batch at a time. Samples below minimum are raised to it.
+class JobLengthSampler {
+    public:
+        explicit JobLengthSampler(const JobLengthSpec& spec, double minimum = MIN_LENGTH, size_t batch_size = 1024)
+            : spec_(spec), minimum_(minimum), gen_(std::random_device{}()), batch_(batch_size), pos_(batch_size) {}
+
+        double next() {
+            if (pos_ == batch_.size()) {
+                refill();
+            }
+            return batch_[pos_++];
+        }
+
+    private:
+        // By default samples are kept strictly positive, since a job always takes some time.
+        static constexpr double MIN_LENGTH = 1e-3;
+
+        void refill() {
+            switch (spec_.kind) {
+                case JobLengthSpec::Kind::Uniform: {
+                    std::uniform_real_distribution<> dist(spec_.a, spec_.b);
+                    for (double& x : batch_) x = dist(gen_);
+                    break;
+                }
+                case JobLengthSpec::Kind::LogNormal: {
+                    std::lognormal_distribution<> dist(spec_.a, spec_.b);
+                    for (double& x : batch_) x = dist(gen_);
+                    break;
+                }
+                case JobLengthSpec::Kind::Weibull: {
+                    std::weibull_distribution<> dist(spec_.a, spec_.b);
+                    for (double& x : batch_) x = dist(gen_);
+                    break;
+                }
+                case JobLengthSpec::Kind::Empirical: {
+                    // Draw all uniforms first, then map them through the histogram.
+                    std::uniform_real_distribution<> unit(0.0, 1.0);
+                    for (double& x : batch_) x = unit(gen_);
+                    const double total = spec_.cumulative.back();
+                    for (size_t i = 0; i < batch_.size(); i++) {
+                        double u = batch_[i] * total;
+                        size_t bin = std::upper_bound(spec_.cumulative.begin(), spec_.cumulative.end(), u) - spec_.cumulative.begin();
+                        bin = std::min(bin, spec_.cumulative.size() - 1);
+                        double prev = bin == 0 ? 0.0 : spec_.cumulative[bin - 1];
+                        double within = spec_.cumulative[bin] > prev ? (u - prev) / (spec_.cumulative[bin] - prev) : 0.5;
+                        batch_[i] = spec_.lower[bin] + within * (spec_.upper[bin] - spec_.lower[bin]);
+                    }
+                    break;
+                }
+            }
+            for (double& x : batch_) {
+                x = std::max(x, minimum_);
+            }
+            pos_ = 0;
+        }
+
+        JobLengthSpec spec_;
+        double minimum_;
+        std::mt19937_64 gen_;
+        std::vector<double> batch_;
+        size_t pos_;
+};
+
+// Job length models for all queues: a default model plus optional per-queue models.
+class JobLengthConfig {
+    public:
+        JobLengthConfig() = default;
+
+        // value is either a single model ("lognormal:1.5,0.9") used for every queue, or a JSON file
+        // with a "default" model and per-queue models under "queues".
+        explicit JobLengthConfig(const std::string& value) {
+            if (value.size() < 5 || value.compare(value.size() - 5, 5, ".json") != 0) {
+                default_ = parseJobLengthSpec(value);
+                return;
+            }
+            std::ifstream file(value);
+            if (!file.is_open()) {
+                throw std::runtime_error("Error: Could not open " + value);
+            }
+            nlohmann::json j;
+            file >> j;
+            if (!file) {
+                throw std::runtime_error("Error: Failed to parse " + value);
+            }
+            try {
+                if (j.contains("default")) {
+                    default_ = parseJobLengthSpec(j["default"].get<std::string>());
+                }
+                if (j.contains("queues")) {
+                    for (const auto& [queue, model] : j["queues"].items()) {
+                        queues_[queue] = parseJobLengthSpec(model.get<std::string>());
+                    }
+                }
+            } catch (const nlohmann::json::exception& e) {
+                throw std::runtime_error("Error: Invalid job length model in " + value + ": " + e.what());
+            }
+        }
+
+        const JobLengthSpec& forQueue(const std::string& queue) const {
+            auto it = queues_.find(queue);
+            return it != queues_.end() ? it->second : default_;
+        }
+
+    private:
+        JobLengthSpec default_;
+        std::map<std::string, JobLengthSpec> queues_;
+};
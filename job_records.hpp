@@ -0,0 +1,148 @@
+// Streaming reader for per-job records (grid example, --replay).
+//
+// A record file is CSV with one finished job per line:
+//
+//     submit_time,site,walltime,cores,error_code
+//
+// with the submit time and walltime in seconds and the final error code of the job (0 for success). Lines starting
+// with '#' and a header line starting with "submit_time" are skipped, and so are blank lines. Record files of real
+// PanDA jobs easily hold hundreds of millions of lines, so the file is never loaded whole: it is read in fixed-size
+// chunks with fread() and parsed in place, one record per call, which keeps the memory use constant and the reading
+// at disk speed.
+#pragma once
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct JobRecord {
+    double submit_time = 0.0;
+    std::string site;  // reused between records, so reading does not allocate once it is large enough
+    double walltime = 0.0;
+    int cores = 1;
+    int error_code = 0;
+};
+
+class JobRecordReader {
+    public:
+        // Opens the record file. chunk_size is the number of bytes read at once; a line must fit into one chunk.
+        explicit JobRecordReader(const std::string& path, size_t chunk_size = 1 << 20)
+            : path_(path), file_(std::fopen(path.c_str(), "rb")), buffer_(chunk_size + 1)
+        {
+            if (file_ == nullptr) {
+                throw std::runtime_error("Error: Could not open record file " + path);
+            }
+        }
+
+        ~JobRecordReader() {
+            if (file_ != nullptr) {
+                std::fclose(file_);
+            }
+        }
+
+        JobRecordReader(const JobRecordReader&) = delete;
+        JobRecordReader& operator=(const JobRecordReader&) = delete;
+
+        // Reads the next record; returns false at the end of the file. Malformed lines throw with their line number.
+        bool next(JobRecord& record) {
+            char* line;
+            while ((line = nextLine()) != nullptr) {
+                line_number_++;
+                if (*line == '\0' || *line == '#' || std::strncmp(line, "submit_time", 11) == 0) {
+                    continue;
+                }
+                parse(line, record);
+                return true;
+            }
+            return false;
+        }
+
+        long lineNumber() const { return line_number_; }
+
+    private:
+        // Next line of the file, terminated in place, or nullptr at the end. Refills the buffer when no complete line
+        // is left: the unread tail moves to the front and the rest of the buffer is filled with one fread().
+        char* nextLine() {
+            while (true) {
+                char* start = buffer_.data() + begin_;
+                char* newline = static_cast<char*>(std::memchr(start, '\n', end_ - begin_));
+                if (newline != nullptr) {
+                    *newline = '\0';
+                    begin_ = newline + 1 - buffer_.data();
+                    if (newline > start && newline[-1] == '\r') {
+                        newline[-1] = '\0';
+                    }
+                    return start;
+                }
+                if (eof_) {
+                    if (begin_ == end_) {
+                        return nullptr;
+                    }
+                    // The last line has no newline.
+                    buffer_[end_] = '\0';
+                    begin_ = end_;
+                    return start;
+                }
+                if (begin_ == 0 && end_ == buffer_.size() - 1) {
+                    throw std::runtime_error("Error: Line " + std::to_string(line_number_ + 1) + " of " + path_ +
+                                             " is longer than the read buffer");
+                }
+                std::memmove(buffer_.data(), start, end_ - begin_);
+                end_ -= begin_;
+                begin_ = 0;
+                size_t read = std::fread(buffer_.data() + end_, 1, buffer_.size() - 1 - end_, file_);
+                if (read == 0) {
+                    if (std::ferror(file_)) {
+                        throw std::runtime_error("Error: Failed to read record file " + path_);
+                    }
+                    eof_ = true;
+                }
+                end_ += read;
+            }
+        }
+
+        void parse(char* line, JobRecord& record) {
+            char* field = line;
+            char* end;
+            errno = 0;
+            record.submit_time = std::strtod(field, &end);
+            bool ok = end != field && *end == ',';
+            if (ok) {
+                field = end + 1;
+                char* comma = std::strchr(field, ',');
+                ok = comma != nullptr && comma != field;
+                if (ok) {
+                    record.site.assign(field, comma);
+                    field = comma + 1;
+                    record.walltime = std::strtod(field, &end);
+                    ok = end != field && *end == ',' && record.walltime >= 0;
+                }
+            }
+            if (ok) {
+                field = end + 1;
+                record.cores = static_cast<int>(std::strtol(field, &end, 10));
+                ok = end != field && *end == ',' && record.cores >= 1;
+            }
+            if (ok) {
+                field = end + 1;
+                record.error_code = static_cast<int>(std::strtol(field, &end, 10));
+                ok = end != field && (*end == '\0' || *end == ',');
+            }
+            if (!ok || errno == ERANGE) {
+                throw std::runtime_error("Error: Invalid record on line " + std::to_string(line_number_) + " of " + path_ +
+                                         " (expected submit_time,site,walltime,cores,error_code)");
+            }
+        }
+
+        std::string path_;
+        std::FILE* file_;
+        std::vector<char> buffer_;  // one byte more than a chunk, for the terminator of an unterminated last line
+        size_t begin_ = 0;          // first unread byte
+        size_t end_ = 0;            // end of the data read so far
+        bool eof_ = false;
+        long line_number_ = 0;
+};
@@ -0,0 +1,76 @@
+// Retry policy for failed jobs, shared by the cluster and grid examples.
+//
+// A failed job is resubmitted when its error code is retryable and it has attempts left. Retries
+// can be delayed by an exponential backoff: base * factor^(retry number - 1), with the factor 2 unless
+// --retry-backoff-factor sets it (1 keeps the delay constant).
+#pragma once
+
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+struct RetryPolicy {
+    int max_attempts = 1;          // total attempts per job, 1 disables retries
+    double backoff = 0.0;          // delay before the first retry in seconds
+    double backoff_factor = 2.0;   // growth of the delay for every further retry
+    std::set<int> retryable_codes; // empty: every nonzero error code is retryable
+
+    bool enabled() const { return max_attempts > 1; }
+
+    // attempt is the number of the attempt that just failed (starting at 1).
+    bool shouldRetry(int error_code, int attempt) const {
+        return error_code != 0 && attempt < max_attempts &&
+               (retryable_codes.empty() || retryable_codes.count(error_code) > 0);
+    }
+
+    // Delay before resubmitting a job whose attempt number attempt failed.
+    double delay(int attempt) const {
+        return backoff * std::pow(backoff_factor, attempt - 1);
+    }
+};
+
+// Builds a retry policy from the command-line values. codes is a comma-separated list of error
+// codes or "all". Codes that never occur in the historical data (known_codes, as in
+// error_codes.json) are reported, since they cannot trigger a retry.
+inline RetryPolicy parseRetryPolicy(const std::string& max_attempts, const std::string& backoff,
+                                    const std::string& backoff_factor, const std::string& codes,
+                                    const std::map<std::string, int>& known_codes) {
+    RetryPolicy policy;
+    try {
+        if (!max_attempts.empty()) {
+            policy.max_attempts = std::stoi(max_attempts);
+        }
+        if (!backoff.empty()) {
+            policy.backoff = std::stod(backoff);
+        }
+        if (!backoff_factor.empty()) {
+            policy.backoff_factor = std::stod(backoff_factor);
+        }
+        if (!codes.empty() && codes != "all") {
+            std::stringstream ss(codes);
+            std::string code;
+            while (std::getline(ss, code, ',')) {
+                if (code.empty()) {
+                    continue;
+                }
+                policy.retryable_codes.insert(std::stoi(code));
+                if (!known_codes.empty() && known_codes.count(code) == 0) {
+                    std::cout << "Warning: retryable error code " << code << " does not occur in the historical data" << std::endl;
+                }
+            }
+        }
+    } catch (const std::logic_error& e) {
+        throw std::runtime_error("Error: Invalid value for --max-attempts, --retry-backoff, --retry-backoff-factor or --retry-codes.");
+    }
+    if (policy.max_attempts < 1 || policy.backoff < 0) {
+        throw std::runtime_error("Error: --max-attempts must be at least 1 and --retry-backoff must not be negative.");
+    }
+    if (!(policy.backoff_factor >= 1)) {
+        throw std::runtime_error("Error: --retry-backoff-factor must be at least 1.");
+    }
+    return policy;
+}
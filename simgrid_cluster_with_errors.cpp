@@ -5,6 +5,7 @@
 #include <string>
 #include <algorithm>
 #include <unordered_map>
+#include <vector>
 #include <mutex>
 
 XBT_LOG_NEW_DEFAULT_CATEGORY(simgrid_example, "SimGrid Job Scheduler Example");
@@ -16,6 +17,24 @@ static int g_total_success = 0;
 static std::unordered_map<int,int> g_error_counts; // maps error_code -> count
 static std::mutex g_mutex;  // For thread-safe updates, if needed.
 
+// Completion counting: the worker that finishes the last job releases the semaphore the master waits on.
+static int g_unfinished_jobs = 0;
+static SemaphorePtr g_all_jobs_done;
+
+// Compile-time verbosity. Build with -DSIM_LOG_LEVEL=0 to compile the per-job logging out of the
+// worker and master loops entirely (no XBT_* calls and no string formatting per job).
+#ifndef SIM_LOG_LEVEL
+#define SIM_LOG_LEVEL 1
+#endif
+constexpr bool kVerbose = SIM_LOG_LEVEL > 0;
+
+// Number of worker hosts used from platform.xml.
+const int NUM_WORKERS = 10;
+
+// Worker hosts and mailboxes, resolved once in main() and indexed by worker number.
+static std::vector<Host*> g_worker_hosts;
+static std::vector<Mailbox*> g_worker_mailboxes;
+
 // A simple Job structure with an error_code.
 struct Job {
     std::string name;
@@ -24,42 +43,38 @@ struct Job {
     Job(const std::string &n, double l) : name(n), load(l), error_code(0) {}
 };
 
-// Worker actor: processes jobs and terminates when receiving a termination message.
-void worker() {
-    XBT_INFO("Worker %s: Starting", this_actor::get_name().c_str());
-    Mailbox* mbox = Mailbox::by_name(this_actor::get_name());
+// Worker actor: processes jobs until the simulation ends. Workers run as daemons and end with the master.
+template <bool Verbose>
+void worker(int index) {
+    const char* name = g_worker_hosts[index]->get_cname();  // actors are named after their host
+    if constexpr (Verbose)
+        XBT_INFO("Worker %s: Starting", name);
+    Mailbox* mbox = g_worker_mailboxes[index];
     while (true) {
         Job* job = mbox->get<Job>();
-        // Termination signal: if the job name is "exit", break out of the loop.
-        if (job->name == "exit") {
-            XBT_INFO("Worker %s: Received termination signal. Exiting.", this_actor::get_name().c_str());
-            delete job;
-            break;
-        }
-        XBT_INFO("Worker %s: Received job %s with load %f",
-                 this_actor::get_name().c_str(), job->name.c_str(), job->load);
+        if constexpr (Verbose)
+            XBT_INFO("Worker %s: Received job %s with load %f",
+                     name, job->name.c_str(), job->load);
         
-        double elapsed = 0.0;
-        double slice = 0.1;  // Process in increments of 0.1 seconds.
-        while (elapsed < job->load) {
-            if (elapsed >= 10.0) {
+        // Jobs longer than the time limit are aborted when they reach it, so a single sleep covers the run.
+        const double time_limit = 10.0;
+        double elapsed = std::min(job->load, time_limit);
+        this_actor::sleep_for(elapsed);
+        if (job->load > time_limit) {
+            if constexpr (Verbose)
                 XBT_WARN("Worker %s: Aborting job %s after 10 seconds", 
-                         this_actor::get_name().c_str(), job->name.c_str());
-                job->error_code = -1;
-                break;
-            }
-            double remaining = job->load - elapsed;
-            double sleep_time = std::min(slice, remaining);
-            this_actor::sleep_for(sleep_time);
-            elapsed += sleep_time;
+                         name, job->name.c_str());
+            job->error_code = -1;
         }
         
-        if (job->error_code == 0) {
-            XBT_INFO("Worker %s: Completed job %s in %f seconds", 
-                     this_actor::get_name().c_str(), job->name.c_str(), elapsed);
-        } else {
-            XBT_INFO("Worker %s: Job %s finished with error code %d", 
-                     this_actor::get_name().c_str(), job->name.c_str(), job->error_code);
+        if constexpr (Verbose) {
+            if (job->error_code == 0) {
+                XBT_INFO("Worker %s: Completed job %s in %f seconds", 
+                         name, job->name.c_str(), elapsed);
+            } else {
+                XBT_INFO("Worker %s: Job %s finished with error code %d", 
+                         name, job->name.c_str(), job->error_code);
+            }
         }
         
         // Update global summary counters.
@@ -71,51 +86,63 @@ void worker() {
                 g_error_counts[job->error_code]++;
         }
         delete job;
+        if (--g_unfinished_jobs == 0)
+            g_all_jobs_done->release();
     }
 }
 
-// Master actor: creates and sends jobs, then sends termination messages.
-void master() {
-    XBT_INFO("Master: Starting");
-    int num_jobs = 20;  // Total number of jobs.
+// Master actor: creates and sends jobs, then waits until the workers have finished them all. The simulation ends
+// when the master returns, since it is the only actor that is not a daemon.
+template <bool Verbose>
+void master(int num_jobs) {
+    if constexpr (Verbose)
+        XBT_INFO("Master: Starting");
     for (int i = 0; i < num_jobs; i++) {
         // Generate a job load between 1 and 15 seconds.
         double job_time = 1.0 + (static_cast<double>(rand()) / RAND_MAX) * 14.0;
-        Job* job = new Job("job" + std::to_string(i), job_time);
+        // The job name is only used for logging, so the quiet build does not format it.
+        Job* job = new Job(Verbose ? "job" + std::to_string(i) : std::string(), job_time);
         // Round-robin assignment: send to one of the workers.
-        std::string worker_name = "worker" + std::to_string(i % 10);
-        Mailbox::by_name(worker_name)->put(job, sizeof(Job));
-        XBT_INFO("Master: Sent job %s with load %f to %s", 
-                 job->name.c_str(), job->load, worker_name.c_str());
-    }
-    
-    // Send termination messages (a "poison pill") to each worker.
-    for (int i = 0; i < 10; i++) {
-        std::string worker_name = "worker" + std::to_string(i);
-        Job* term_job = new Job("exit", 0.0);
-        Mailbox::by_name(worker_name)->put(term_job, sizeof(Job));
-        XBT_INFO("Master: Sent termination signal to %s", worker_name.c_str());
+        int w = i % NUM_WORKERS;
+        g_worker_mailboxes[w]->put(job, sizeof(Job));
+        if constexpr (Verbose)
+            XBT_INFO("Master: Sent job %s with load %f to %s", 
+                     job->name.c_str(), job->load, g_worker_hosts[w]->get_cname());
     }
+
+    if (num_jobs > 0)
+        g_all_jobs_done->acquire();
+    if constexpr (Verbose)
+        XBT_INFO("Master: All jobs finished. Exiting.");
 }
 
 int main(int argc, char* argv[]) {
     Engine e(&argc, argv);
     e.load_platform("platform.xml");
 
+    // Resolve the worker hosts and their mailboxes once.
+    for (int i = 0; i < NUM_WORKERS; i++) {
+        std::string host_name = "worker" + std::to_string(i);
+        g_worker_hosts.push_back(Host::by_name(host_name));
+        g_worker_mailboxes.push_back(Mailbox::by_name(host_name));
+    }
+
+    const int total_jobs = 20;
+    g_unfinished_jobs = total_jobs;
+    g_all_jobs_done = Semaphore::create(0);
+
     // Create the master actor on host "worker0".
-    Actor::create("master", Host::by_name("worker0"), master);
+    Actor::create("master", g_worker_hosts[0], master<kVerbose>, total_jobs);
     
     // Create 10 worker actors, each bound to its corresponding host.
-    for (int i = 0; i < 10; i++) {
-        std::string host_name = "worker" + std::to_string(i);
-        Actor::create(host_name, Host::by_name(host_name), worker);
+    for (int i = 0; i < NUM_WORKERS; i++) {
+        Actor::create(g_worker_hosts[i]->get_name(), g_worker_hosts[i], worker<kVerbose>, i)->daemonize();
     }
 
     e.run();
 
     // After simulation run is finished, print a summary.
     std::cout << "\n=== Simulation Summary ===" << std::endl;
-    int total_jobs = 20;  // as sent by master
     int total_success = g_total_success;
     int total_failures = total_jobs - total_success;
     std::cout << "Total jobs: " << total_jobs << std::endl;
@@ -1,27 +1,42 @@
+#include <simgrid/plugins/energy.h>
 #include <simgrid/s4u.hpp>
-#include <nlohmann/json.hpp>
 
 #include <algorithm>
+#include <cmath>
 #include <cstdlib>
+#include <deque>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <mutex>
+#include <queue>
 #include <random>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <utility> // for std::pair
 
+#include "error_code_generator.hpp"
+#include "error_regimes.hpp"
+#include "failure_timing.hpp"
+#include "fair_share.hpp"
+#include "job_dag.hpp"
+#include "job_event_log.hpp"
+#include "job_length_model.hpp"
+#include "retry_policy.hpp"
+
 XBT_LOG_NEW_DEFAULT_CATEGORY(simgrid_example, "SimGrid Job Scheduler Example");
 
 using namespace simgrid::s4u;
 using namespace std;
-using json = nlohmann::json;
 
 // Global counters for job outcomes.
 static int g_total_success = 0;
 static unordered_map<int,int> g_error_counts; // maps error_code -> count
+static map<int,double> g_wasted_time; // maps error_code -> seconds spent on failed attempts
 static mutex g_mutex;  // For thread-safe updates, if needed.
 
 // A simple Job structure with an error_code.
@@ -29,54 +44,526 @@ struct Job {
     string name;
     double load;      // Total simulated processing time required.
     int error_code;   // 0 means success; nonzero (e.g., -1) indicates an error.
-    Job(const string &n, double l) : name(n), load(l), error_code(0) {}
+    long id;          // Sequence number of the job, used by the event log.
+    int attempt;      // 1 for the first submission, incremented on every retry.
+    double ready_time;  // Earliest resubmission time of a retried job.
+    double input_size;   // Bytes staged in from the storage before the run.
+    double output_size;  // Bytes staged out to the storage after a successful run.
+    int group;           // Job group (queue) with --queues, 0 otherwise.
+    double submit_time;  // Arrival time of the job, for the latency statistics.
+    Job(const string &n, double l, long i = -1)
+        : name(n), load(l), error_code(0), id(i), attempt(1), ready_time(0.0), input_size(0.0), output_size(0.0), group(0),
+          submit_time(0.0) {}
 };
 
-// Use a constant for the max number of workers
-const int MAX_WORKERS = 20;
+// Number of worker hosts: the 20 hosts of platform.xml, or with --workers <n> a cluster of n hosts built in code with
+// the same host, link and power parameters (see createClusterPlatform()). --dispatch steal and --dispatch-fanout
+// also use the built cluster, since they send between workers.
+string num_workers;
+int g_numWorkers = 20;
+
+// Worker hosts and mailboxes, resolved once in main() and indexed by worker number, so that
+// dispatch does not build "workerN" strings or look names up for every job.
+vector<Host*> g_workerHosts;
+vector<Mailbox*> g_workerMailboxes;
 
-// Use --mute to suppress verbose output (setting XBT_LOG_DEFAULT_LEVEL does not work to suppress messages since XBT_LOG_NEW_DEFAULT_CATEGORY has already been called)
+// Compile-time verbosity. Build with -DSIM_LOG_LEVEL=0 to compile the per-job logging out of the
+// worker and master loops entirely (no XBT_* calls and no string formatting per job).
+#ifndef SIM_LOG_LEVEL
+#define SIM_LOG_LEVEL 1
+#endif
+constexpr bool kLoggingCompiledIn = SIM_LOG_LEVEL > 0;
+
+// Use --mute to suppress verbose output (setting XBT_LOG_DEFAULT_LEVEL does not work to suppress messages since XBT_LOG_NEW_DEFAULT_CATEGORY has already been called).
+// The flag is only read once in main() to pick the quiet or verbose actor instantiation, never inside the job loop.
 bool muted = false;
 
+// Use --event-log <file> to write a binary per-job event log (see job_event_log.hpp and job_event_log_decoder.cpp).
+string event_log_file;
+JobEventLog* g_eventLog = nullptr;
+
+// Use --max-attempts <n> [--retry-backoff <seconds> [--retry-backoff-factor <factor>]] [--retry-codes <code,code,...|all>]
+// to resubmit failed jobs.
+// Retryable failures go to the resubmitter actor, which puts them back into the round-robin dispatch after the backoff.
+// Workers hand them over through an in-memory inbox rather than a network transfer, so a handoff cannot be lost
+// when the worker's host fails right after the job.
+string retry_max_attempts, retry_backoff, retry_backoff_factor, retry_codes;
+RetryPolicy g_retryPolicy;
+deque<Job*> g_retryInbox;
+SemaphorePtr g_retryAvailable;  // one token per job in g_retryInbox
+SemaphorePtr g_allJobsDone;  // released when the last job has reached its final state
+int g_unfinishedJobs = 0;
+
+// Retry accounting for the queue.
+static long g_attempts = 0;
+static long g_retries = 0;
+static double g_cpu_time = 0.0;        // seconds spent on all attempts
+static double g_retry_cpu_time = 0.0;  // seconds spent on attempts after the first one
+static unordered_map<int,int> g_retried_error_counts;
+
+// Use --failure-timing <file> to load per-error-code times to failure (see failure_timing.hpp);
+// by default failed jobs are aborted after 10 seconds.
+string failure_timing_file;
+FailureTimingModel* g_failureTiming = nullptr;
+
+// Use --job-length <model|file.json> to draw job loads from another distribution (see
+// job_length_model.hpp); by default loads are uniform between 1 and 15 seconds.
+string job_length_model;
+JobLengthSampler* g_jobLength = nullptr;
+
+// Use --mtbf <seconds> [--mttr <seconds>] to inject host outages: every worker host except worker0 (which runs the
+// master and the resubmitter) goes down after an exponentially distributed uptime with mean MTBF and comes back after
+// an exponentially distributed repair time with mean MTTR. The worker on a failed host is killed, the job it was
+// running is lost and resubmitted, and the worker is restarted once the host is back.
+string host_mtbf, host_mttr;
+struct HostOutages {
+    double mtbf = 0.0;  // 0 disables host outages
+    double mttr = 600.0;
+    long failures = 0;
+    double downtime = 0.0;   // host-seconds spent down
+    long lost_jobs = 0;
+    double lost_time = 0.0;  // seconds of work lost with the failed hosts
+};
+HostOutages g_outages;
+vector<Job*> g_runningJobs;     // job running on each worker, nullptr when idle
+vector<double> g_runningSince;  // start time of that job
+
+// Use --input-size <model> and --output-size <model> to stage data in and out of every job, with sizes in MB
+// drawn from the models of job_length_model.hpp (e.g. "2000" or "lognormal:7,0.5"). The files live on the
+// storage of worker0 and move over the platform links, so all transfers share the link of worker0.
+string input_size_model, output_size_model;
+JobLengthSampler* g_inputSize = nullptr;
+JobLengthSampler* g_outputSize = nullptr;
+static double g_bytes_in = 0.0;
+static double g_bytes_out = 0.0;
+static double g_link_bytes = 0.0;      // bytes that crossed the link, i.e. not staged by worker0 itself
+static double g_stage_in_time = 0.0;   // seconds spent staging in
+static double g_stage_out_time = 0.0;  // seconds spent staging out
+
+// Moves bytes between two hosts and returns the transfer time.
+double stage(Host* from, Host* to, double bytes) {
+    double start = Engine::get_clock();
+    Comm::sendto(from, to, static_cast<uint64_t>(bytes));
+    if (from != to) {
+        g_link_bytes += bytes;
+    }
+    return Engine::get_clock() - start;
+}
+
+// Use --energy to enable the SimGrid host energy plugin with the power profiles of platform.xml. Jobs then load the
+// CPU of their host (an execution instead of a sleep), and the energy the host consumes during an attempt, from
+// stage-in to stage-out, is charged to that attempt: to the successful jobs, or to the error code of a failed one.
+bool energy_enabled = false;
+vector<double> g_runningEnergy;  // energy consumed by each worker host when its running job started
+static double g_success_energy = 0.0;     // joules spent on successful attempts
+static map<int,double> g_wasted_energy;  // maps error_code -> joules spent on failed attempts
+static double g_lost_energy = 0.0;        // joules spent on attempts lost with a failed host
+
+// Use --task-chain <stage[:jobs[:load factor]],...> to run tasks instead of independent jobs; --n then sets the number
+// of tasks, each a chain of stages such as evgen -> simul -> reco -> merge (see job_dag.hpp). The master submits the
+// first stage of every task; every other job is created and handed to the resubmitter once all of its parents have
+// succeeded, and the descendants of a job that has failed for good are cancelled.
+string task_chain;
+struct TaskGraph {
+    JobDag* dag = nullptr;  // nullptr without --task-chain
+    vector<int> remaining;  // jobs of each task that have not reached a final state
+    vector<double> submit;  // arrival time of each task
+    vector<bool> failed;    // a job of the task has failed for good
+    vector<double> times;   // completion times of the tasks whose jobs all succeeded
+    long cancelled_jobs = 0;
+    long failed_tasks = 0;
+};
+TaskGraph g_tasks;
+
+// Jobs come back to the resubmitter when they are retried or lost with a host, and DAG jobs go through it once
+// they are ready.
+bool resubmissionEnabled() {
+    return g_retryPolicy.enabled() || g_outages.mtbf > 0 || g_tasks.dag;
+}
+
+// Hands a job to the resubmitter.
+void resubmit(Job* job) {
+    g_retryInbox.push_back(job);
+    g_retryAvailable->release();
+}
+
+// Use --pilot-lifetime <seconds> to run pilots instead of permanent workers. Every worker host holds a batch slot
+// in which pilots run one after the other: a pilot spends --pilot-startup seconds bootstrapping, then repeatedly
+// pays --fetch-overhead seconds to pull a payload from the central task queue and runs it, as long as its
+// remaining walltime still covers --payload-walltime seconds. The master and the resubmitter then fill the task
+// queue instead of sending jobs to the workers (late binding).
+string pilot_lifetime, pilot_startup, fetch_overhead, payload_walltime;
+struct PilotPool {
+    double lifetime = 0.0;  // 0 disables pilots
+    double startup = 30.0;
+    double fetch_overhead = 2.0;
+    double payload_walltime = 15.0;
+    vector<double> since;   // start time of the pilot on each worker, -1 when there is none
+    long pilots = 0;
+    long fetches = 0;
+    long empty_fetches = 0;     // fetches that found no payload before the pilot had to give up
+    long overruns = 0;          // payloads that ended after their pilot's lifetime
+    double slot_time = 0.0;     // seconds held by pilots
+    double payload_time = 0.0;  // seconds of pilot time spent on payloads, including staging
+};
+PilotPool g_pilotPool;
+
+// Central task queue that pilots, instances, pulling workers and the fair-share dispatcher take jobs from.
+deque<Job*> g_taskQueue;
+SemaphorePtr g_jobsAvailable;  // one token per job in g_taskQueue
+int g_queuedJobs = 0;          // jobs waiting in g_taskQueue or the fair-share queues
+
+bool pilotMode() {
+    return g_pilotPool.lifetime > 0;
+}
+
+// Use --autoscale-max <instances> to run the workers as cloud instances (e.g. for TOKYO_CLOUD). An autoscaler
+// checks the task queue every --scale-interval seconds and starts instances, one per --jobs-per-instance queued
+// jobs on top of the busy ones, between --autoscale-min and --autoscale-max; an instance boots for --boot-time
+// seconds before it takes jobs. Surplus instances are stopped once the queue has been short for
+// --scale-down-delay seconds. Every instance costs --instance-cost dollars per hour from boot to stop.
+string autoscale_min, autoscale_max, boot_time, scale_interval, scale_down_delay, jobs_per_instance, instance_cost;
+struct InstancePool {
+    int min_instances = 1;
+    int max_instances = 0;  // 0 disables autoscaling
+    double boot_time = 60.0;
+    double scale_interval = 30.0;
+    double scale_down_delay = 300.0;
+    double jobs_per_instance = 1.0;
+    double cost = 0.10;     // dollars per instance hour
+    vector<double> since;   // start time of the instance on each worker host, -1 when there is none
+    int active = 0;           // booting or running instances
+    int busy = 0;             // instances running a job
+    int retire_requests = 0;  // instances the autoscaler asked to stop; the next idle ones do
+    long started = 0;
+    int peak = 0;
+    double instance_time = 0.0;  // seconds billed over all instances
+    double busy_time = 0.0;
+};
+InstancePool g_instancePool;
+
+bool autoscaling() {
+    return g_instancePool.max_instances > 0;
+}
+
+// Use --arrival-rate <jobs per second> to submit the jobs over time instead of all at once. Jobs arrive in bursts
+// of geometrically distributed size with mean --burst-size (default 1, i.e. Poisson arrivals), and the bursts
+// are spaced so that the mean rate is kept. The latency of every job, from arrival to its final state, is then
+// reported.
+string arrival_rate, burst_size;
+double g_arrivalRate = 0.0;  // 0 submits every job at the start
+double g_burstSize = 1.0;
+vector<double> g_latencies;
+
+// Use --prefetch <K> to let every worker (with push dispatch) keep receives for K more jobs posted while it runs a
+// job, as pilots prefetch their next payloads, so that the transfer of the next job is off the critical path.
+// Jobs a worker has received but not started are handed to the resubmitter when its host fails.
+string prefetch_depth;
+struct Prefetching {
+    int depth = 0;
+    vector<vector<Job*>> slots;  // per worker, K + 1 receive slots; a job waits in its slot until it starts
+    double receive_wait = 0.0;   // seconds workers spent waiting for their next job
+};
+Prefetching g_prefetch;
 
-class ErrorCodeGenerator {
-    public:
-        // The constructor initializes the weights and the discrete distribution.
-        ErrorCodeGenerator(const std::map<std::string, int>& errorCodes)
-            : errorCodes_(errorCodes), gen_(std::random_device{}())
-        {
-            // Build the weights vector from the error codes
-            for (const auto& pair : errorCodes_) {
-                weights_.push_back(pair.second);
-            }
-            dist_ = std::discrete_distribution<>(weights_.begin(), weights_.end());
-        }
-        
-        // This function returns the next random error code.
-        int getNextErrorCode() {
-            // Generate a random index based on the weights
-            int randomIndex = dist_(gen_);
-            // Get the corresponding error code from the map.
-            auto it = std::next(errorCodes_.cbegin(), randomIndex);
+// Use --dispatch <push|pull|steal> to choose how the jobs reach the workers. push (the default) sends every job to the
+// next worker in round-robin order, where it waits in the worker's mailbox. pull keeps the jobs in a central queue
+// that idle workers take them from. steal pushes the jobs round-robin into worker-local deques; a worker runs the
+// jobs of its own deque from the front and, once it is empty, asks random other workers through their steal
+// mailboxes for the newer half of their deques. A worker that finds nothing waits up to --steal-backoff seconds
+// for a local job before it tries again. Setting --dispatch also reports the turnaround of the jobs.
+enum class DispatchMode { Push, Pull, Steal };
+string dispatch_mode, steal_backoff;
+DispatchMode g_dispatchMode = DispatchMode::Push;
+const int STEAL_ATTEMPTS = 3;        // victims asked per steal
+const double STEAL_TIMEOUT = 1.0;    // seconds to wait for a victim that may have failed with its host
+struct StealRequest {
+    int thief;
+};
+struct WorkStealing {
+    double backoff = 1.0;
+    vector<deque<Job*>> local_queues;
+    vector<SemaphorePtr> local_available;  // one token per job pushed to a local deque; stale once the job is stolen
+    vector<Mailbox*> requests;             // steal requests to the responder of each worker
+    vector<Mailbox*> replies;              // stolen jobs for each thief
+    vector<vector<Job*>*> in_flight;       // per victim, the jobs its responder is handing to a thief, or nullptr
+    mt19937 rng{random_device{}()};
+    long steal_requests = 0;
+    long steals = 0;  // requests that returned jobs
+    long stolen_jobs = 0;
+};
+WorkStealing g_stealing;
+static double g_last_end = 0.0;    // time the last job reached its final state
+
+bool latencyEnabled() {
+    return g_arrivalRate > 0 || autoscaling() || !dispatch_mode.empty();
+}
+
+// Use --queues <queue:share,queue:share,...> instead of --queue to simulate several queues (job groups) at once.
+// Every group has its own historical error distribution and job length model, and the jobs are split evenly
+// between the groups. Jobs wait in per-group queues, and the next free worker (or pilot) gets a job of the
+// group with the lowest decayed usage per share target (see fair_share.hpp). The usage half-life is set with
+// --fair-share-half-life <seconds>.
+string fair_share_queues, fair_share_half_life;
+struct JobGroup {
+    string name;
+    ErrorCodeGenerator* errors = nullptr;
+    TimeVaryingErrorGenerator* regimes = nullptr;  // replaces errors with --error-regimes
+    JobLengthSampler* lengths = nullptr;
+    deque<Job*> waiting;
+    long succeeded = 0;
+    long failed = 0;
+    long started = 0;         // attempts started
+    double wait_time = 0.0;   // seconds between becoming ready and starting, over all attempts
+    double cpu_time = 0.0;    // seconds spent on all attempts
+    long attempts = 0;        // attempts finished
+    long retries = 0;
+    double retry_cpu_time = 0.0;  // seconds spent on attempts after the first one
+    double last_end = 0.0;    // time the last job of the group reached its final state
+};
+vector<JobGroup> g_groups;
+FairShare g_fairShare;
+
+bool fairShareEnabled() {
+    return !g_groups.empty();
+}
+
+// Parses "queue:share,queue:share,..."; a queue without a share gets share 1.
+vector<pair<string, double>> parseQueueShares(const string& value) {
+    vector<pair<string, double>> queues;
+    stringstream ss(value);
+    string item;
+    while (getline(ss, item, ',')) {
+        if (item.empty()) {
+            continue;
+        }
+        auto colon = item.rfind(':');
+        double share = 1.0;
+        if (colon != string::npos) {
             try {
-                // Convert the error code string to int.
-                return std::stoi(it->first);
-            } catch (const std::invalid_argument& e) {
-                std::cout << "Error: '" << it->first << "' is not a valid integer error code." << std::endl;
-                return -1; // or handle the error appropriately
+                share = stod(item.substr(colon + 1));
+            } catch (const logic_error& e) {
+                throw runtime_error("Error: Invalid share in --queues entry " + item);
+            }
+        }
+        queues.emplace_back(item.substr(0, colon), share);
+    }
+    return queues;
+}
+
+// Queues a job for the pilots or the fair-share dispatcher.
+void queueJob(Job* job) {
+    if (fairShareEnabled()) {
+        g_groups[job->group].waiting.push_back(job);
+        g_fairShare.activate(job->group);
+    } else {
+        g_taskQueue.push_back(job);
+    }
+    g_queuedJobs++;
+    g_jobsAvailable->release();
+}
+
+// Takes the next queued job; the caller holds a token of g_jobsAvailable. Under fair share, the job comes from the
+// group with the lowest effective priority, and its load is charged to the group right away so that jobs started
+// before it ends see it. The charge is corrected to the actual run time when the attempt ends.
+Job* takeJob() {
+    g_queuedJobs--;
+    if (!fairShareEnabled()) {
+        Job* job = g_taskQueue.front();
+        g_taskQueue.pop_front();
+        return job;
+    }
+    int g = g_fairShare.top();
+    JobGroup& group = g_groups[g];
+    Job* job = group.waiting.front();
+    group.waiting.pop_front();
+    if (group.waiting.empty()) {
+        g_fairShare.deactivate(g);
+    }
+    g_fairShare.charge(g, job->load, Engine::get_clock());
+    return job;
+}
+
+// Round-robin position over a contiguous range of workers. Hosts that are down are skipped; the first host of a
+// range never fails, so there is always a worker to return.
+struct WorkerRange {
+    int first = 0;
+    int count = 0;
+    int next = 0;  // offset of the next worker in the range
+};
+
+// All workers, shared by the master and the resubmitter.
+WorkerRange g_allWorkers;
+
+int nextWorker(WorkerRange& range) {
+    while (true) {
+        int w = range.first + range.next;
+        if (++range.next == range.count) {
+            range.next = 0;
+        }
+        if (g_workerHosts[w]->is_on()) {
+            return w;
+        }
+    }
+}
+
+// Use --dispatch-fanout <k> to dispatch through a two-level tree instead of from the master alone: the workers are
+// split into k contiguous shards, each owned by a sub-dispatcher on its first host. The master hands the jobs to the
+// sub-dispatchers in turn, in batches of one job per worker of the shard, and every sub-dispatcher sends the jobs of
+// its batches to its own workers. The master then sends one message per batch instead of one per job, and the shards
+// are served in parallel. Like worker0, the hosts of the sub-dispatchers do not fail.
+string dispatch_fanout;
+struct Shard {
+    WorkerRange workers;
+    Mailbox* mailbox = nullptr;
+};
+struct DispatchTree {
+    int fanout = 0;  // 0 dispatches every job from the master
+    vector<Shard> shards;
+};
+DispatchTree g_dispatchTree;
+
+// Dispatch accounting over first attempts, from the creation of a job to its handoff to a worker.
+static long g_handoffs = 0;
+static double g_dispatch_latency = 0.0;
+static double g_last_handoff = 0.0;
+
+bool neverFails(int w) {
+    if (w == 0) {
+        return true;
+    }
+    for (const Shard& shard : g_dispatchTree.shards) {
+        if (shard.workers.first == w) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Sends a job to the next worker of a range that is up and returns its index. When the receiving host fails during
+// the transfer, the job is sent to another worker.
+int sendToWorker(Job* job, WorkerRange& range = g_allWorkers) {
+    while (true) {
+        int w = nextWorker(range);
+        try {
+            g_workerMailboxes[w]->put(job, sizeof(Job));
+            if (job->attempt == 1) {
+                g_handoffs++;
+                g_dispatch_latency += Engine::get_clock() - job->submit_time;
+                g_last_handoff = Engine::get_clock();
             }
+            return w;
+        } catch (const simgrid::NetworkFailureException&) {
+            // The receiver went down with its host; the job never arrived.
         }
-        
-    private:
-        std::map<std::string, int> errorCodes_;
-        std::vector<double> weights_;
-        std::mt19937 gen_;
-        std::discrete_distribution<> dist_;
-    };
+    }
+}
+
+// Dispatches a job: to the next worker, or with pilots, autoscaled instances, fair share or pull dispatch to the
+// queue they take jobs from, in which case -1 is returned.
+int dispatch(Job* job) {
+    if (pilotMode() || autoscaling() || fairShareEnabled() || g_dispatchMode == DispatchMode::Pull) {
+        queueJob(job);
+        return -1;
+    }
+    if (g_dispatchMode == DispatchMode::Steal) {
+        int w = nextWorker(g_allWorkers);
+        g_stealing.local_queues[w].push_back(job);
+        g_stealing.local_available[w]->release();
+        return w;
+    }
+    return sendToWorker(job);
+}
+
+// Name of the worker a job was dispatched to, for the log messages.
+const char* dispatchTarget(int w) {
+    if (w >= 0) {
+        return g_workerHosts[w]->get_cname();
+    }
+    return g_dispatchTree.fanout > 0 ? "a sub-dispatcher" : "the task queue";
+}
+
+// Hands the batch the master has filled to the sub-dispatcher of its shard and starts an empty batch for the next
+// shard.
+void sendBatch(vector<Job*>*& batch, int& shard) {
+    if (batch->empty()) {
+        return;
+    }
+    g_dispatchTree.shards[shard].mailbox->put(batch, batch->size() * sizeof(Job));
+    batch = new vector<Job*>();
+    if (++shard == static_cast<int>(g_dispatchTree.shards.size())) {
+        shard = 0;
+    }
+}
+
+// Modes that change how jobs reach the workers or how they come back after a host failure. Every mode keeps its
+// state in its own struct above. All combinations are supported except the pairs listed in MODE_CONFLICTS, which
+// main() rejects before the run; a new mode must be checked against all others and its conflicts added here.
+enum class Mode { Pilots, Autoscaling, FairShare, DispatchTree, PullDispatch, WorkStealing, Prefetching, HostOutages, TaskDags };
+struct ModeConflict {
+    Mode a;
+    Mode b;
+    const char* reason;
+};
+const ModeConflict MODE_CONFLICTS[] = {
+    {Mode::Pilots, Mode::Autoscaling, "pilots and instances would both hold the worker hosts"},
+    {Mode::DispatchTree, Mode::Pilots, "pilots take their jobs from the task queue"},
+    {Mode::DispatchTree, Mode::Autoscaling, "instances take their jobs from the task queue"},
+    {Mode::DispatchTree, Mode::FairShare, "fair share hands the jobs out from the group queues"},
+    {Mode::PullDispatch, Mode::Pilots, "pilots already pull their jobs"},
+    {Mode::PullDispatch, Mode::Autoscaling, "instances already pull their jobs"},
+    {Mode::PullDispatch, Mode::FairShare, "fair share hands the jobs out from the group queues"},
+    {Mode::PullDispatch, Mode::DispatchTree, "the dispatch tree pushes the jobs to the workers"},
+    {Mode::WorkStealing, Mode::Pilots, "pilots take their jobs from the task queue"},
+    {Mode::WorkStealing, Mode::Autoscaling, "instances take their jobs from the task queue"},
+    {Mode::WorkStealing, Mode::FairShare, "fair share hands the jobs out from the group queues"},
+    {Mode::WorkStealing, Mode::DispatchTree, "the dispatch tree sends the jobs to the worker mailboxes"},
+    {Mode::Prefetching, Mode::Pilots, "prefetching needs push dispatch to permanent workers"},
+    {Mode::Prefetching, Mode::Autoscaling, "prefetching needs push dispatch to permanent workers"},
+    {Mode::Prefetching, Mode::PullDispatch, "prefetching needs push dispatch to permanent workers"},
+    {Mode::Prefetching, Mode::WorkStealing, "prefetching needs push dispatch to permanent workers"},
+};
+
+const char* modeOption(Mode mode) {
+    switch (mode) {
+        case Mode::Pilots:       return "--pilot-lifetime";
+        case Mode::Autoscaling:  return "--autoscale-max";
+        case Mode::FairShare:    return "--queues";
+        case Mode::DispatchTree: return "--dispatch-fanout";
+        case Mode::PullDispatch: return "--dispatch pull";
+        case Mode::WorkStealing: return "--dispatch steal";
+        case Mode::Prefetching:  return "--prefetch";
+        case Mode::HostOutages:  return "--mtbf";
+        case Mode::TaskDags:     return "--task-chain";
+    }
+    return "unknown";
+}
+
+// Whether a mode is selected by the parsed options; usable before the groups and workers are set up.
+bool modeEnabled(Mode mode) {
+    switch (mode) {
+        case Mode::Pilots:       return pilotMode();
+        case Mode::Autoscaling:  return autoscaling();
+        case Mode::FairShare:    return !fair_share_queues.empty();
+        case Mode::DispatchTree: return g_dispatchTree.fanout > 0;
+        case Mode::PullDispatch: return g_dispatchMode == DispatchMode::Pull;
+        case Mode::WorkStealing: return g_dispatchMode == DispatchMode::Steal;
+        case Mode::Prefetching:  return g_prefetch.depth > 0;
+        case Mode::HostOutages:  return g_outages.mtbf > 0;
+        case Mode::TaskDags:     return !task_chain.empty();
+    }
+    return false;
+}
+
 
 // Global pointer to the error code generator.
 ErrorCodeGenerator* g_errorCodeGenerator = nullptr;
 
+// Use --error-regimes <file> to make the error rates vary over simulated time (see error_regimes.hpp);
+// the generator then replaces g_errorCodeGenerator.
+string error_regimes_file;
+TimeVaryingErrorGenerator* g_errorRegimes = nullptr;
+
 // Function to parse command-line arguments
 // Returns a tuple with (input_file, n, queue_name)
 tuple<string, int, string> parseArguments(int argc, char* argv[]) {
@@ -89,8 +576,21 @@ tuple<string, int, string> parseArguments(int argc, char* argv[]) {
             muted = true;
             continue;
         }
+        if (key == "--energy") {
+            energy_enabled = true;
+            continue;
+        }
         // These options require a value.
-        if (key == "--input" || key == "--n" || key == "--queue") {
+        if (key == "--input" || key == "--n" || key == "--queue" || key == "--event-log" ||
+            key == "--max-attempts" || key == "--retry-backoff" || key == "--retry-codes" || key == "--failure-timing" ||
+            key == "--retry-backoff-factor" || key == "--job-length" || key == "--mtbf" || key == "--mttr" || key == "--error-regimes" ||
+            key == "--input-size" || key == "--output-size" || key == "--pilot-lifetime" || key == "--pilot-startup" ||
+            key == "--fetch-overhead" || key == "--payload-walltime" || key == "--queues" || key == "--fair-share-half-life" ||
+            key == "--autoscale-min" || key == "--autoscale-max" || key == "--boot-time" || key == "--scale-interval" ||
+            key == "--scale-down-delay" || key == "--jobs-per-instance" || key == "--instance-cost" ||
+            key == "--arrival-rate" || key == "--burst-size" || key == "--workers" || key == "--dispatch-fanout" ||
+            key == "--dispatch" || key == "--steal-backoff" || key == "--prefetch" ||
+            key == "--task-chain") {
             if (i + 1 >= argc) {
                 throw runtime_error("Error: Missing value for " + key);
             }
@@ -107,10 +607,46 @@ tuple<string, int, string> parseArguments(int argc, char* argv[]) {
     if (args.find("--n") == args.end()) {
         throw runtime_error("Error: Missing --n argument.");
     }
-    if (args.find("--queue") == args.end()) {
+    if (args.find("--queue") == args.end() && args.find("--queues") == args.end()) {
         throw runtime_error("Error: Missing --queue argument.");
     }
 
+    if (args.find("--event-log") != args.end()) {
+        event_log_file = args["--event-log"];
+    }
+    retry_max_attempts = args["--max-attempts"];
+    retry_backoff = args["--retry-backoff"];
+    retry_backoff_factor = args["--retry-backoff-factor"];
+    retry_codes = args["--retry-codes"];
+    failure_timing_file = args["--failure-timing"];
+    job_length_model = args["--job-length"];
+    host_mtbf = args["--mtbf"];
+    host_mttr = args["--mttr"];
+    error_regimes_file = args["--error-regimes"];
+    input_size_model = args["--input-size"];
+    output_size_model = args["--output-size"];
+    pilot_lifetime = args["--pilot-lifetime"];
+    pilot_startup = args["--pilot-startup"];
+    fetch_overhead = args["--fetch-overhead"];
+    payload_walltime = args["--payload-walltime"];
+    fair_share_queues = args["--queues"];
+    fair_share_half_life = args["--fair-share-half-life"];
+    autoscale_min = args["--autoscale-min"];
+    autoscale_max = args["--autoscale-max"];
+    boot_time = args["--boot-time"];
+    scale_interval = args["--scale-interval"];
+    scale_down_delay = args["--scale-down-delay"];
+    jobs_per_instance = args["--jobs-per-instance"];
+    instance_cost = args["--instance-cost"];
+    arrival_rate = args["--arrival-rate"];
+    burst_size = args["--burst-size"];
+    num_workers = args["--workers"];
+    dispatch_fanout = args["--dispatch-fanout"];
+    dispatch_mode = args["--dispatch"];
+    steal_backoff = args["--steal-backoff"];
+    prefetch_depth = args["--prefetch"];
+    task_chain = args["--task-chain"];
+
     string input_file = args["--input"];
     string queue_name = args["--queue"];
     int n;
@@ -126,113 +662,854 @@ tuple<string, int, string> parseArguments(int argc, char* argv[]) {
 }
 
 
-// Worker actor: processes jobs and terminates when receiving a termination message.
-void worker() {
+// Creates a job with a load from the job length model of its group and sizes from the staging models. The load of a
+// DAG job is scaled by the factor of its stage.
+template <bool Verbose>
+Job* createJob(long id, int group) {
+    double job_time = fairShareEnabled() ? g_groups[group].lengths->next() : g_jobLength->next();
+    if (g_tasks.dag) {
+        job_time *= g_tasks.dag->stage(id).load_factor;
+    }
+    Job* job = new Job(Verbose ? "job" + to_string(id) : string(), job_time, id);
+    job->group = group;
+    if (g_inputSize) {
+        job->input_size = g_inputSize->next() * 1e6;
+    }
+    if (g_outputSize) {
+        job->output_size = g_outputSize->next() * 1e6;
+    }
+    return job;
+}
+
+// Updates the DAG once a job has reached its final state: a success submits the children that have become ready, a
+// failure cancels all descendants. The task is complete when its last job is done or cancelled.
+template <bool Verbose>
+void releaseDependents(Job* job) {
+    long task = g_tasks.dag->task(job->id);
+    vector<long> nodes;
+    if (job->error_code == 0) {
+        g_tasks.dag->succeed(job->id, nodes);
+        for (long node : nodes) {
+            Job* child = createJob<Verbose>(node, job->group);
+            child->submit_time = Engine::get_clock();
+            child->ready_time = child->submit_time;
+            resubmit(child);
+        }
+    } else {
+        g_tasks.dag->cancelDescendants(job->id, nodes);
+        if constexpr (Verbose) {
+            XBT_INFO("Job %s failed, cancelling %zu dependent jobs", job->name.c_str(), nodes.size());
+        }
+        g_tasks.failed[task] = true;
+        g_tasks.cancelled_jobs += nodes.size();
+        g_tasks.remaining[task] -= static_cast<int>(nodes.size());
+        g_unfinishedJobs -= static_cast<int>(nodes.size());
+    }
+    if (--g_tasks.remaining[task] == 0) {
+        if (g_tasks.failed[task]) {
+            g_tasks.failed_tasks++;
+        } else {
+            g_tasks.times.push_back(Engine::get_clock() - g_tasks.submit[task]);
+        }
+    }
+}
+
+
+// Runs one attempt of a job on a worker: stages the data, draws the error code and either finishes the job,
+// hands it to the resubmitter or counts it as failed.
+template <bool Verbose>
+void processJob(int index, Job* job) {
+    const char* name = g_workerHosts[index]->get_cname();
+    JobGroup* group = fairShareEnabled() ? &g_groups[job->group] : nullptr;
+    if (group) {
+        group->started++;
+        group->wait_time += Engine::get_clock() - job->ready_time;
+    }
+    if constexpr (Verbose) {
+        XBT_INFO("Worker %s: Received job %s with load %f",
+                 name, job->name.c_str(), job->load);
+    }
+    if (g_eventLog) {
+        g_eventLog->record(job->id, index, JobEvent::Started, Engine::get_clock());
+    }
+
+    // Simulate the exit code of the job (will be 0 most of the time)
+    int exit_code;
+    if (group) {
+        exit_code = group->regimes ? group->regimes->getNextErrorCode(Engine::get_clock()) : group->errors->getNextErrorCode();
+    } else {
+        exit_code = g_errorRegimes ? g_errorRegimes->getNextErrorCode(Engine::get_clock())
+                                   : g_errorCodeGenerator->getNextErrorCode();
+    }
+    if (exit_code != 0) {
+        job->error_code = exit_code;
+        if constexpr (Verbose) {
+            XBT_WARN("Worker %s: Simulated error %d on job %s", 
+                     name, exit_code, job->name.c_str());
+        }
+    }
+
+    // A failed job runs until its error-specific time to failure, a successful one for its whole load,
+    // so each job is a single timed activity.
+    double elapsed = job->error_code == 0 ? job->load : g_failureTiming->timeToFailure(job->error_code, job->load);
+    bool aborted = elapsed < job->load;
+    g_runningJobs[index] = job;
+    g_runningSince[index] = Engine::get_clock();
+    if (energy_enabled) {
+        g_runningEnergy[index] = sg_host_get_consumed_energy(g_workerHosts[index]);
+    }
+    if (job->input_size > 0) {
+        g_stage_in_time += stage(g_workerHosts[0], g_workerHosts[index], job->input_size);
+        g_bytes_in += job->input_size;
+    }
+    if (energy_enabled) {
+        this_actor::execute(elapsed * g_workerHosts[index]->get_speed());
+    } else {
+        this_actor::sleep_for(elapsed);
+    }
+    if (job->output_size > 0 && job->error_code == 0) {
+        g_stage_out_time += stage(g_workerHosts[index], g_workerHosts[0], job->output_size);
+        g_bytes_out += job->output_size;
+    }
+    if (energy_enabled) {
+        double energy = sg_host_get_consumed_energy(g_workerHosts[index]) - g_runningEnergy[index];
+        if (job->error_code == 0) {
+            g_success_energy += energy;
+        } else {
+            g_wasted_energy[job->error_code] += energy;
+        }
+    }
+    g_runningJobs[index] = nullptr;
+    if constexpr (Verbose) {
+        if (aborted) {
+            XBT_WARN("Worker %s: Aborted failed job %s after %f seconds",
+                     name, job->name.c_str(), elapsed);
+        }
+    }
+
+    if constexpr (Verbose) {
+        if (job->error_code == 0) {
+            XBT_INFO("Worker %s: Completed job %s in %f seconds", 
+                     name, job->name.c_str(), elapsed);
+        } else {
+            XBT_INFO("Worker %s: Job %s finished with error code %d", 
+                     name, job->name.c_str(), job->error_code);
+        }
+    }
+    if (g_eventLog) {
+        JobEvent event = job->error_code == 0 ? JobEvent::Succeeded : aborted ? JobEvent::Aborted : JobEvent::Failed;
+        g_eventLog->record(job->id, index, event, Engine::get_clock(), job->error_code);
+    }
+
+    g_attempts++;
+    g_cpu_time += elapsed;
+    if (job->attempt > 1) {
+        g_retry_cpu_time += elapsed;
+    }
+    if (job->error_code != 0) {
+        g_wasted_time[job->error_code] += elapsed;
+    }
+    if (group) {
+        group->cpu_time += elapsed;
+        group->attempts++;
+        if (job->attempt > 1) {
+            group->retry_cpu_time += elapsed;
+        }
+        g_fairShare.charge(job->group, elapsed - job->load, Engine::get_clock());
+    }
+
+    // Hand a retryable failure to the resubmitter instead of counting it as failed.
+    if (g_retryPolicy.shouldRetry(job->error_code, job->attempt)) {
+        double delay = g_retryPolicy.delay(job->attempt);
+        if constexpr (Verbose) {
+            XBT_INFO("Worker %s: Resubmitting job %s (attempt %d) in %f seconds",
+                     name, job->name.c_str(), job->attempt + 1, delay);
+        }
+        if (g_eventLog) {
+            g_eventLog->record(job->id, index, JobEvent::Retried, Engine::get_clock(), job->error_code);
+        }
+        g_retries++;
+        if (group) {
+            group->retries++;
+        }
+        g_retried_error_counts[job->error_code]++;
+        job->ready_time = Engine::get_clock() + delay;
+        job->attempt++;
+        job->error_code = 0;
+        resubmit(job);
+        return;
+    }
+
+    // Update global summary counters.
+    {
+        lock_guard<mutex> lock(g_mutex);
+        if (job->error_code == 0)
+            ++g_total_success;
+        else
+            g_error_counts[job->error_code]++;
+    }
+    if (group) {
+        (job->error_code == 0 ? group->succeeded : group->failed)++;
+        group->last_end = Engine::get_clock();
+    }
+    if (latencyEnabled()) {
+        g_latencies.push_back(Engine::get_clock() - job->submit_time);
+    }
+    if (g_tasks.dag) {
+        releaseDependents<Verbose>(job);
+    }
+    g_last_end = Engine::get_clock();
+    delete job;
+    if (--g_unfinishedJobs == 0) {
+        g_allJobsDone->release();
+    }
+}
+
+
+// Worker actor: processes jobs until the simulation ends. Workers run as daemons, so they end with the master once
+// every job has finished, without termination messages.
+// Verbose selects at compile time whether the logging statements exist at all.
+// The worker keeps --prefetch receives posted while it runs a job, in a ring of slots that the mailbox fills in
+// the order the jobs were sent, so the next jobs are already transferred when the current one ends.
+template <bool Verbose>
+void worker(int index) {
+
+    // The actor is named after its host, so the cached host name is used in the log messages.
+    const char* name = g_workerHosts[index]->get_cname();
+    if constexpr (Verbose) {
+        XBT_INFO("Worker %s: Starting", name);
+    }
+
+    Mailbox* mbox = g_workerMailboxes[index];
+    vector<Job*>& slots = g_prefetch.slots[index];
+    vector<CommPtr> receives(slots.size());
+    for (size_t i = 0; i < slots.size(); i++) {
+        receives[i] = mbox->get_async<Job>(&slots[i]);
+    }
+    for (size_t next = 0;; next = (next + 1) % slots.size()) {
+        double wait_start = Engine::get_clock();
+        receives[next]->wait();
+        g_prefetch.receive_wait += Engine::get_clock() - wait_start;
+        Job* job = slots[next];
+        slots[next] = nullptr;
+        processJob<Verbose>(index, job);
+        receives[next] = mbox->get_async<Job>(&slots[next]);
+    }
+}
+
+
+// Pulling worker actor (--dispatch pull): takes the next job from the central queue whenever it is idle. Pulling
+// workers run as daemons and end with the master.
+template <bool Verbose>
+void pullingWorker(int index) {
+    if constexpr (Verbose) {
+        XBT_INFO("Worker %s: Starting", g_workerHosts[index]->get_cname());
+    }
+    while (true) {
+        g_jobsAvailable->acquire();
+        processJob<Verbose>(index, takeJob());
+    }
+}
+
 
-    if (!muted) {
-        XBT_INFO("Worker %s: Starting", this_actor::get_name().c_str());
+// Asks up to STEAL_ATTEMPTS random other workers for jobs and moves the first jobs it gets to the front of the
+// thief's own deque, in their original order. Returns whether any job was stolen.
+template <bool Verbose>
+bool steal(int index) {
+    WorkStealing& stealing = g_stealing;
+    if (g_numWorkers < 2) {
+        return false;
+    }
+    uniform_int_distribution<int> victims(0, g_numWorkers - 2);
+    for (int attempt = 0; attempt < STEAL_ATTEMPTS; attempt++) {
+        int victim = victims(stealing.rng);
+        if (victim >= index) {
+            victim++;
+        }
+        stealing.steal_requests++;
+        auto* request = new StealRequest{index};
+        try {
+            stealing.requests[victim]->put(request, sizeof(StealRequest), STEAL_TIMEOUT);
+        } catch (const simgrid::Exception&) {
+            // The victim is down (or gone with its host); the request never arrived.
+            delete request;
+            continue;
+        }
+        vector<Job*>* loot;
+        try {
+            loot = stealing.replies[index]->get<vector<Job*>>(STEAL_TIMEOUT);
+        } catch (const simgrid::Exception&) {
+            // No reply in time, or the reply failed with the victim's host; a failed reply is resubmitted there.
+            continue;
+        }
+        bool stolen = !loot->empty();
+        if (stolen) {
+            stealing.steals++;
+            stealing.stolen_jobs += loot->size();
+            if constexpr (Verbose) {
+                XBT_INFO("Worker %s: Stole %zu jobs from %s", g_workerHosts[index]->get_cname(), loot->size(),
+                         g_workerHosts[victim]->get_cname());
+            }
+            // The loot comes newest first.
+            for (Job* job : *loot) {
+                stealing.local_queues[index].push_front(job);
+            }
+        }
+        delete loot;
+        if (stolen) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Stealing worker actor (--dispatch steal): runs the jobs of its own deque and steals when it is empty. Stealing
+// workers run as daemons and end with the master.
+template <bool Verbose>
+void stealingWorker(int index) {
+    WorkStealing& stealing = g_stealing;
+    if constexpr (Verbose) {
+        XBT_INFO("Worker %s: Starting", g_workerHosts[index]->get_cname());
+    }
+    deque<Job*>& local = stealing.local_queues[index];
+    const SemaphorePtr& available = stealing.local_available[index];
+    while (true) {
+        if (local.empty()) {
+            // With the deque empty, all tokens left are stale (their jobs were run or stolen); drop them so that only
+            // a job pushed from now on ends the backoff below.
+            while (!available->would_block()) {
+                available->acquire();
+            }
+            if (!steal<Verbose>(index)) {
+                available->acquire_timeout(stealing.backoff);
+                continue;
+            }
+        }
+        Job* job = local.front();
+        local.pop_front();
+        processJob<Verbose>(index, job);
     }
+}
 
-    Mailbox* mbox = Mailbox::by_name(this_actor::get_name());
+// Steal responder actor of a worker: answers every steal request with the newer half of the worker's deque, so a
+// worker can be stolen from while it runs a job. Jobs whose thief is gone by the time of the reply go back. The
+// loot stays in g_stealing.in_flight until the reply is over, so hostFailures resubmits it if the host fails meanwhile.
+template <bool Verbose>
+void stealResponder(int index) {
+    WorkStealing& stealing = g_stealing;
+    deque<Job*>& local = stealing.local_queues[index];
     while (true) {
-        Job* job = mbox->get<Job>();
-        // Termination signal: if the job name is "exit", break out of the loop.
-        if (job->name == "exit") {
-            if (!muted) {
-                XBT_INFO("Worker %s: Received termination signal. Exiting.", this_actor::get_name().c_str());
+        StealRequest* request = stealing.requests[index]->get<StealRequest>();
+        int thief = request->thief;
+        delete request;
+        auto* loot = new vector<Job*>();
+        for (size_t n = (local.size() + 1) / 2; n > 0; n--) {
+            loot->push_back(local.back());
+            local.pop_back();
+        }
+        stealing.in_flight[index] = loot;
+        try {
+            stealing.replies[thief]->put(loot, sizeof(Job) * loot->size(), STEAL_TIMEOUT);
+        } catch (const simgrid::Exception&) {
+            for (auto it = loot->rbegin(); it != loot->rend(); ++it) {
+                local.push_back(*it);
             }
-            delete job;
+            delete loot;
+        }
+        stealing.in_flight[index] = nullptr;
+    }
+}
+
+
+// Pilot actor: holds the batch slot of a worker host for at most the pilot lifetime. After bootstrapping, it
+// pulls payloads from the task queue while its remaining walltime still covers a payload, and exits when it
+// no longer does or when no payload arrives in time.
+template <bool Verbose>
+void pilot(int index) {
+    PilotPool& pool = g_pilotPool;
+    const char* name = g_workerHosts[index]->get_cname();
+    double start = Engine::get_clock();
+    double end = start + pool.lifetime;
+    pool.since[index] = start;
+    pool.pilots++;
+    if constexpr (Verbose) {
+        XBT_INFO("Pilot %s: Starting", name);
+    }
+    this_actor::sleep_for(pool.startup);
+
+    // Remaining-walltime check before every fetch.
+    while (end - Engine::get_clock() - pool.fetch_overhead >= pool.payload_walltime) {
+        this_actor::sleep_for(pool.fetch_overhead);
+        pool.fetches++;
+        // Wait for a payload only as long as one could still be run to the end.
+        double patience = end - Engine::get_clock() - pool.payload_walltime;
+        if (g_jobsAvailable->acquire_timeout(max(patience, 0.0))) {
+            pool.empty_fetches++;
+            break;
+        }
+        Job* job = takeJob();
+        double payload_start = Engine::get_clock();
+        processJob<Verbose>(index, job);
+        pool.payload_time += Engine::get_clock() - payload_start;
+        if (Engine::get_clock() > end) {
+            pool.overruns++;
+        }
+    }
+
+    pool.slot_time += Engine::get_clock() - start;
+    pool.since[index] = -1.0;
+    if constexpr (Verbose) {
+        XBT_INFO("Pilot %s: Walltime left %f seconds, exiting", name, end - Engine::get_clock());
+    }
+}
+
+// Batch slot of a worker host with pilots: starts a new pilot whenever the previous one has exited. Slots run
+// as daemons, so they end with the master once every job has finished.
+template <bool Verbose>
+void pilotSlot(int index) {
+    while (true) {
+        pilot<Verbose>(index);
+    }
+}
+
+
+// Cloud instance actor: boots, then takes jobs from the task queue until the autoscaler asks for an instance to
+// stop and this one is idle. Idle instances look for a stop request once per scaling interval.
+template <bool Verbose>
+void instance(int index) {
+    InstancePool& pool = g_instancePool;
+    const char* name = g_workerHosts[index]->get_cname();
+    double start = pool.since[index];
+    if constexpr (Verbose) {
+        XBT_INFO("Instance %s: Booting", name);
+    }
+    this_actor::sleep_for(pool.boot_time);
+
+    while (true) {
+        if (pool.retire_requests > 0) {
+            pool.retire_requests--;
             break;
         }
-        if (!muted) {
-            XBT_INFO("Worker %s: Received job %s with load %f",
-                     this_actor::get_name().c_str(), job->name.c_str(), job->load);
+        if (g_jobsAvailable->acquire_timeout(pool.scale_interval)) {
+            continue;
         }
+        Job* job = takeJob();
+        double job_start = Engine::get_clock();
+        pool.busy++;
+        processJob<Verbose>(index, job);
+        pool.busy--;
+        pool.busy_time += Engine::get_clock() - job_start;
+    }
 
-        // Simulate the exit code of the job (will be 0 most of the time)
-        int exit_code = g_errorCodeGenerator->getNextErrorCode();
-        if (exit_code != 0) {
-            job->error_code = exit_code;
-            if (!muted) {
-                XBT_WARN("Worker %s: Simulated error %d on job %s", 
-                         this_actor::get_name().c_str(), exit_code, job->name.c_str());
+    pool.instance_time += Engine::get_clock() - start;
+    pool.since[index] = -1.0;
+    pool.active--;
+    if constexpr (Verbose) {
+        XBT_INFO("Instance %s: Stopped", name);
+    }
+}
+
+// Autoscaler actor: sizes the pool of instances to the busy instances plus one instance per --jobs-per-instance
+// queued jobs. It scales up at once, cancelling pending stop requests first, and scales down only after the pool
+// has been larger than needed for the whole scale-down delay, so that short gaps between bursts do not pay the
+// boot time again.
+template <bool Verbose>
+void autoscaler() {
+    InstancePool& instances = g_instancePool;
+    double surplus_since = -1.0;
+    while (true) {
+        int wanted = instances.busy + static_cast<int>(ceil(g_queuedJobs / instances.jobs_per_instance));
+        wanted = min(max(wanted, instances.min_instances), instances.max_instances);
+        int pool = instances.active - instances.retire_requests;
+        if (wanted > pool) {
+            int cancelled = min(instances.retire_requests, wanted - pool);
+            instances.retire_requests -= cancelled;
+            pool += cancelled;
+            // Instances start on worker hosts that are up and free.
+            for (int i = 0; i < g_numWorkers && pool < wanted; i++) {
+                if (instances.since[i] >= 0 || !g_workerHosts[i]->is_on()) {
+                    continue;
+                }
+                instances.since[i] = Engine::get_clock();
+                instances.active++;
+                instances.started++;
+                pool++;
+                Actor::create(g_workerHosts[i]->get_name(), g_workerHosts[i], instance<Verbose>, i)->daemonize();
+            }
+            instances.peak = max(instances.peak, instances.active);
+            surplus_since = -1.0;
+            if constexpr (Verbose) {
+                XBT_INFO("Autoscaler: %d jobs queued, scaling up to %d instances", g_queuedJobs, pool);
+            }
+        } else if (wanted < pool) {
+            if (surplus_since < 0) {
+                surplus_since = Engine::get_clock();
+            }
+            if (Engine::get_clock() - surplus_since >= instances.scale_down_delay) {
+                instances.retire_requests += pool - wanted;
+                surplus_since = -1.0;
+                if constexpr (Verbose) {
+                    XBT_INFO("Autoscaler: %d jobs queued, scaling down to %d instances", g_queuedJobs, wanted);
+                }
             }
+        } else {
+            surplus_since = -1.0;
         }
+        this_actor::sleep_for(instances.scale_interval);
+    }
+}
+
 
-        double elapsed = 0.0;
-        double slice = 0.1;  // Process in increments of 0.1 seconds.
-        while (elapsed < job->load) {
-            if (elapsed >= 10.0 && job->error_code != 0) {
-                if (!muted) {
-                    XBT_WARN("Worker %s: Aborting failed job %s after 10 seconds",
-                             this_actor::get_name().c_str(), job->name.c_str());
+// Master actor: creates and sends jobs, then waits until every job has finished. All other actors are daemons, so
+// the simulation ends when the master returns; shutdown costs the same for any number of workers.
+// The job name is only used for logging, so the quiet instantiation does not build it.
+template <bool Verbose>
+void master(int num_jobs) {
+
+    if constexpr (Verbose) {
+        XBT_INFO("Master: Starting");
+    }
+    // With --arrival-rate, bursts of jobs arrive at exponentially spaced times; the arrival times are absolute,
+    // so a master that is held up by a busy worker does not slow the arrivals down.
+    mt19937 gen(random_device{}());
+    exponential_distribution<> burst_gap(g_arrivalRate > 0 ? g_arrivalRate / g_burstSize : 1.0);
+    geometric_distribution<int> burst_extra(1.0 / g_burstSize);
+    double arrival = 0.0;
+    int burst_left = 0;
+    // With --dispatch-fanout, jobs are collected into a batch for one shard after the other.
+    vector<Job*>* batch = g_dispatchTree.fanout > 0 ? new vector<Job*>() : nullptr;
+    int shard = 0;
+    // With --task-chain, every arrival is a task, of which the jobs of the first stage are submitted.
+    const long arrivals = g_tasks.dag ? g_tasks.dag->tasks() : num_jobs;
+    for (long i = 0; i < arrivals; i++) {
+        if (g_arrivalRate > 0) {
+            if (burst_left == 0) {
+                if (i > 0) {
+                    arrival += burst_gap(gen);
                 }
-                break;
+                burst_left = 1 + burst_extra(gen);
+            }
+            burst_left--;
+            if (arrival > Engine::get_clock()) {
+                // Jobs that have arrived are not held back until the next arrival.
+                if (batch) {
+                    sendBatch(batch, shard);
+                }
+                this_actor::sleep_until(arrival);
             }
-            double remaining = job->load - elapsed;
-            double sleep_time = min(slice, remaining);
-            this_actor::sleep_for(sleep_time);
-            elapsed += sleep_time;
         }
-        
-        if (!muted) {
-            if (job->error_code == 0) {
-                XBT_INFO("Worker %s: Completed job %s in %f seconds", 
-                         this_actor::get_name().c_str(), job->name.c_str(), elapsed);
-            } else {
-                XBT_INFO("Worker %s: Job %s finished with error code %d", 
-                         this_actor::get_name().c_str(), job->name.c_str(), job->error_code);
+        // With --queues, the jobs (or tasks) go to the groups in turn and follow the job length model of their group.
+        int group = fairShareEnabled() ? static_cast<int>(i % static_cast<long>(g_groups.size())) : 0;
+        double submit_time = g_arrivalRate > 0 ? arrival : Engine::get_clock();
+        if (g_tasks.dag) {
+            g_tasks.submit[i] = submit_time;
+        }
+        for (long id : g_tasks.dag ? g_tasks.dag->roots(i) : vector<long>{i}) {
+            Job* job = createJob<Verbose>(id, group);
+            job->submit_time = submit_time;
+            job->ready_time = submit_time;
+            // The dispatch is logged before the handoff, which may block and be retried on another worker; the worker
+            // that gets the job is recorded with its Started event.
+            if (g_eventLog) {
+                g_eventLog->record(id, -1, JobEvent::Dispatched, Engine::get_clock());
+            }
+            if (batch) {
+                if constexpr (Verbose) {
+                    XBT_INFO("Master: Queued job %s with load %f for sub-dispatcher %d", job->name.c_str(), job->load, shard);
+                }
+                batch->push_back(job);
+                if (static_cast<int>(batch->size()) == g_dispatchTree.shards[shard].workers.count) {
+                    sendBatch(batch, shard);
+                }
+                continue;
+            }
+            // Round-robin assignment: send to one of the workers.
+            int w = dispatch(job);
+            if constexpr (Verbose) {
+                XBT_INFO("Master: Sent job %s with load %f to %s", 
+                         job->name.c_str(), job->load, dispatchTarget(w));
             }
         }
-        // Update global summary counters.
-        {
-            lock_guard<mutex> lock(g_mutex);
-            if (job->error_code == 0)
-                ++g_total_success;
-            else
-                g_error_counts[job->error_code]++;
+    }
+    if (batch) {
+        sendBatch(batch, shard);
+        delete batch;
+    }
+
+    // Jobs keep running after the last one has been sent (and, with retries or host outages, come back), until every
+    // job has succeeded or given up; the last one to reach its final state releases the semaphore.
+    if (num_jobs > 0) {
+        g_allJobsDone->acquire();
+    }
+    if constexpr (Verbose) {
+        XBT_INFO("Master: All jobs finished. Exiting.");
+    }
+}
+
+
+// Resubmitter actor: collects retryable failures and jobs lost with a failed host and puts each one back
+// into the round-robin dispatch once its backoff has expired. Pending retries are kept ordered by ready time.
+template <bool Verbose>
+void resubmitter() {
+    using PendingRetry = pair<double, Job*>;
+    priority_queue<PendingRetry, vector<PendingRetry>, greater<PendingRetry>> pending;
+    while (true) {
+        if (pending.empty()) {
+            g_retryAvailable->acquire();
+            Job* job = g_retryInbox.front();
+            g_retryInbox.pop_front();
+            pending.emplace(job->ready_time, job);
+            continue;
+        }
+        // Keep collecting new retries until the earliest pending one is due.
+        double wait = pending.top().first - Engine::get_clock();
+        if (wait > 0 && !g_retryAvailable->acquire_timeout(wait)) {
+            Job* job = g_retryInbox.front();
+            g_retryInbox.pop_front();
+            pending.emplace(job->ready_time, job);
+            continue;
+        }
+        Job* job = pending.top().second;
+        pending.pop();
+        if (g_eventLog) {
+            g_eventLog->record(job->id, -1, JobEvent::Dispatched, Engine::get_clock());
+        }
+        int w = dispatch(job);
+        if constexpr (Verbose) {
+            XBT_INFO("Resubmitter: Sent job %s (attempt %d) to %s",
+                     job->name.c_str(), job->attempt, dispatchTarget(w));
         }
-        delete job;
     }
 }
 
 
-// Master actor: creates and sends jobs, then sends termination messages.
-void master(int num_jobs) {
+// Fair-share dispatcher actor (with --queues and permanent workers): hands the queued jobs to the workers in
+// round-robin order, always taking the next job from the group with the lowest effective priority.
+template <bool Verbose>
+void fairShareDispatcher() {
+    while (true) {
+        g_jobsAvailable->acquire();
+        Job* job = takeJob();
+        int w = sendToWorker(job);
+        if constexpr (Verbose) {
+            XBT_INFO("Dispatcher: Sent job %s of %s to %s", job->name.c_str(), g_groups[job->group].name.c_str(),
+                     g_workerHosts[w]->get_cname());
+        }
+    }
+}
 
-    if (!muted) {
-        XBT_INFO("Master: Starting");
+
+// Sub-dispatcher actor (with --dispatch-fanout): sends the jobs of every batch it receives from the master to the
+// workers of its shard in round-robin order. Sub-dispatchers run as daemons and end with the master.
+template <bool Verbose>
+void subDispatcher(int index) {
+    Shard& shard = g_dispatchTree.shards[index];
+    while (true) {
+        vector<Job*>* batch = shard.mailbox->get<vector<Job*>>();
+        for (Job* job : *batch) {
+            int w = sendToWorker(job, shard.workers);
+            if constexpr (Verbose) {
+                XBT_INFO("Sub-dispatcher %d: Sent job %s to %s", index, job->name.c_str(), g_workerHosts[w]->get_cname());
+            }
+        }
+        delete batch;
+    }
+}
+
+
+// Creates the daemon worker actors of a host for pull or steal dispatch.
+template <bool Verbose>
+void createWorker(int index) {
+    Host* host = g_workerHosts[index];
+    if (g_dispatchMode == DispatchMode::Pull) {
+        Actor::create(host->get_name(), host, pullingWorker<Verbose>, index)->daemonize();
+    } else {
+        Actor::create(host->get_name(), host, stealingWorker<Verbose>, index)->daemonize();
+        Actor::create("responder-" + host->get_name(), host, stealResponder<Verbose>, index)->daemonize();
     }
-    for (int i = 0; i < num_jobs; i++) {
-        // Generate a job load between 1 and 15 seconds.
-        double job_time = 1.0 + (static_cast<double>(rand()) / RAND_MAX) * 14.0;
-        Job* job = new Job("job" + to_string(i), job_time);
-        // Round-robin assignment: send to one of the workers.
-        string worker_name = "worker" + to_string(i % MAX_WORKERS);
-        Mailbox::by_name(worker_name)->put(job, sizeof(Job));
-        if (!muted) {
-            XBT_INFO("Master: Sent job %s with load %f to %s", 
-                     job->name.c_str(), job->load, worker_name.c_str());
+}
+
+
+// Host outage actor for one worker host: alternates exponentially distributed up and down times. The job
+// running on the host when it fails is lost and handed to the resubmitter, and the worker is restarted when
+// the host comes back. No new outages start once every job has finished.
+template <bool Verbose>
+void hostFailures(int index) {
+    Host* host = g_workerHosts[index];
+    mt19937 gen(random_device{}());
+    exponential_distribution<> uptime(1.0 / g_outages.mtbf);
+    exponential_distribution<> repair(1.0 / g_outages.mttr);
+    while (true) {
+        this_actor::sleep_for(uptime(gen));
+        if (g_unfinishedJobs == 0) {
+            return;
+        }
+
+        Job* lost = g_runningJobs[index];
+        g_runningJobs[index] = nullptr;
+        // The pilot holding the slot dies with the host; its slot time so far is accounted here.
+        if (pilotMode() && g_pilotPool.since[index] >= 0) {
+            g_pilotPool.slot_time += Engine::get_clock() - g_pilotPool.since[index];
+            g_pilotPool.since[index] = -1.0;
+        }
+        // So does an instance; the autoscaler replaces it on another host if it is still needed.
+        if (autoscaling() && g_instancePool.since[index] >= 0) {
+            g_instancePool.instance_time += Engine::get_clock() - g_instancePool.since[index];
+            g_instancePool.since[index] = -1.0;
+            g_instancePool.active--;
+            if (lost != nullptr) {
+                g_instancePool.busy--;
+            }
+        }
+        if (lost != nullptr && energy_enabled) {
+            g_lost_energy += sg_host_get_consumed_energy(host) - g_runningEnergy[index];
+        }
+        host->turn_off();
+        g_outages.failures++;
+        if constexpr (Verbose) {
+            XBT_WARN("Host %s: Down", host->get_cname());
+        }
+        if (lost != nullptr) {
+            if constexpr (Verbose) {
+                XBT_WARN("Host %s: Lost job %s, resubmitting", host->get_cname(), lost->name.c_str());
+            }
+            if (g_eventLog) {
+                g_eventLog->record(lost->id, index, JobEvent::Lost, Engine::get_clock());
+            }
+            g_outages.lost_jobs++;
+            g_outages.lost_time += Engine::get_clock() - g_runningSince[index];
+            if (fairShareEnabled()) {
+                g_fairShare.charge(lost->group, Engine::get_clock() - g_runningSince[index] - lost->load, Engine::get_clock());
+            }
+            lost->error_code = 0;
+            lost->ready_time = Engine::get_clock();
+            resubmit(lost);
+        }
+        // Jobs prefetched by the worker are handed to the resubmitter as well; they had not started.
+        for (Job*& job : g_prefetch.slots[index]) {
+            if (job != nullptr) {
+                job->ready_time = Engine::get_clock();
+                resubmit(job);
+                job = nullptr;
+            }
+        }
+        // So are the jobs waiting in the deque of a stealing worker, and those its responder was handing to a thief
+        // when the host went down.
+        if (g_dispatchMode == DispatchMode::Steal) {
+            for (Job* job : g_stealing.local_queues[index]) {
+                job->ready_time = Engine::get_clock();
+                resubmit(job);
+            }
+            g_stealing.local_queues[index].clear();
+            if (vector<Job*>* loot = g_stealing.in_flight[index]) {
+                for (Job* job : *loot) {
+                    job->ready_time = Engine::get_clock();
+                    resubmit(job);
+                }
+                delete loot;
+                g_stealing.in_flight[index] = nullptr;
+            }
+        }
+
+        double down = repair(gen);
+        this_actor::sleep_for(down);
+        host->turn_on();
+        g_outages.downtime += down;
+        if constexpr (Verbose) {
+            XBT_INFO("Host %s: Up again", host->get_cname());
+        }
+        if (pilotMode()) {
+            Actor::create(host->get_name(), host, pilotSlot<Verbose>, index)->daemonize();
+        } else if (g_dispatchMode != DispatchMode::Push) {
+            createWorker<Verbose>(index);
+        } else if (!autoscaling()) {
+            Actor::create(host->get_name(), host, worker<Verbose>, index)->daemonize();
         }
     }
+}
+
+
+// Create the master and the worker actors using the quiet or the verbose instantiation.
+template <bool Verbose>
+void create_actors(int total_jobs) {
+    // Create the master actor on host "worker0", passing num_jobs via a lambda.
+    Actor::create("master", g_workerHosts[0], [total_jobs]() { master<Verbose>(total_jobs); });
 
-    // Send termination messages (a "poison pill") to each worker.
-    for (int i = 0; i < MAX_WORKERS; i++) {
-        string worker_name = "worker" + to_string(i);
-        Job* term_job = new Job("exit", 0.0);
-        Mailbox::by_name(worker_name)->put(term_job, sizeof(Job));
-        if (!muted) {
-            XBT_INFO("Master: Sent termination signal to %s", worker_name.c_str());
+    // Every other actor runs as a daemon, so they all end with the master.
+    if (resubmissionEnabled()) {
+        Actor::create("resubmitter", g_workerHosts[0], resubmitter<Verbose>)->daemonize();
+    }
+    if (fairShareEnabled() && !pilotMode() && !autoscaling()) {
+        Actor::create("dispatcher", g_workerHosts[0], fairShareDispatcher<Verbose>)->daemonize();
+    }
+    for (size_t i = 0; i < g_dispatchTree.shards.size(); i++) {
+        Host* host = g_workerHosts[g_dispatchTree.shards[i].workers.first];
+        Actor::create("dispatcher-" + to_string(i), host, subDispatcher<Verbose>, static_cast<int>(i))->daemonize();
+    }
+    if (g_outages.mtbf > 0) {
+        for (int i = 1; i < g_numWorkers; i++) {
+            if (neverFails(i)) {
+                continue;
+            }
+            Actor::create("failures-" + g_workerHosts[i]->get_name(), g_workerHosts[0], hostFailures<Verbose>, i)->daemonize();
+        }
+    }
+
+    // Instances are started by the autoscaler instead of the worker loop below.
+    if (autoscaling()) {
+        Actor::create("autoscaler", g_workerHosts[0], autoscaler<Verbose>)->daemonize();
+        return;
+    }
+
+    // Create some worker actors (or pilot slots), each bound to its corresponding host.
+    for (int i = 0; i < g_numWorkers; i++) {
+        if (pilotMode()) {
+            Actor::create(g_workerHosts[i]->get_name(), g_workerHosts[i], pilotSlot<Verbose>, i)->daemonize();
+        } else if (g_dispatchMode != DispatchMode::Push) {
+            createWorker<Verbose>(i);
+        } else {
+            Actor::create(g_workerHosts[i]->get_name(), g_workerHosts[i], worker<Verbose>, i)->daemonize();
         }
     }
 }
 
 
+// Builds a cluster of the given number of worker hosts instead of loading platform.xml. Hosts, link and power
+// profiles match platform.xml: every host reaches the others through its own link, and worker0, which holds the
+// job data, through the link "lnk", so all staging shares that link as before. Must be called after the Engine is
+// created.
+void createClusterPlatform(int workers) {
+    NetZone* zone = create_star_zone("AS0");
+    const Link* storage_link = zone->create_link("lnk", "1GBps")->set_latency("0.5ms")->seal();
+    for (int i = 0; i < workers; i++) {
+        string host_name = "worker" + to_string(i);
+        // The first half of the hosts are of the older generation of platform.xml.
+        bool old = i < workers / 2;
+        Host* host = zone->create_host(host_name, "1Gf")
+                         ->set_property("wattage_per_state", old ? "110.0:110.0:230.0" : "75.0:75.0:180.0")
+                         ->set_property("wattage_off", old ? "10.0" : "5.0");
+        const Link* link = i == 0 ? storage_link : zone->create_link(host_name + "-link", "1GBps")->set_latency("0.5ms")->seal();
+        zone->add_route(host->get_netpoint(), nullptr, nullptr, nullptr, {link}, true);
+    }
+    zone->seal();
+}
+
+
 int main(int argc, char* argv[]) {
 
     // Read input file from arguments --input
     if (argc < 5) {
-        cerr << "Usage: " << argv[0] << " --input <input error file> --queue <queue name> --n <number of jobs>\n";
+        cerr << "Usage: " << argv[0] << " --input <input error file> --queue <queue name> --n <number of jobs> [--mute] [--energy] [--event-log <file>]"
+             << " [--queues <queue:share,...> instead of --queue [--fair-share-half-life <seconds>]]"
+             << " [--max-attempts <n>] [--retry-backoff <seconds> [--retry-backoff-factor <factor>]] [--retry-codes <code,code,...|all>]"
+             << " [--failure-timing <file>] [--job-length <model|file.json>] [--mtbf <seconds> [--mttr <seconds>]]"
+             << " [--error-regimes <file>] [--input-size <MB model>] [--output-size <MB model>]"
+             << " [--pilot-lifetime <seconds> [--pilot-startup <seconds>] [--fetch-overhead <seconds>] [--payload-walltime <seconds>]]"
+             << " [--autoscale-max <instances> [--autoscale-min <instances>] [--boot-time <seconds>] [--scale-interval <seconds>]"
+             << " [--scale-down-delay <seconds>] [--jobs-per-instance <n>] [--instance-cost <dollars per hour>]]"
+             << " [--arrival-rate <jobs per second> [--burst-size <mean jobs per burst>]]"
+             << " [--workers <n>] [--dispatch-fanout <sub-dispatchers>] [--dispatch <push|pull|steal> [--steal-backoff <seconds>]]"
+             << " [--prefetch <jobs>] [--task-chain <stage[:jobs[:load factor]],...> (--n is then the number of tasks)]\n";
         return 1;
     }
 
@@ -243,63 +1520,391 @@ int main(int argc, char* argv[]) {
         // Assign values from function
         tie(input_file, total_jobs, queue_name) = parseArguments(argc, argv);
         cout << "Input File: " << input_file << endl;
-        cout << "Number of jobs: " << total_jobs << endl;
-        cout << "Queue Name: " << queue_name << endl;
+        cout << (task_chain.empty() ? "Number of jobs: " : "Number of tasks: ") << total_jobs << endl;
+        if (fair_share_queues.empty()) {
+            cout << "Queue Name: " << queue_name << endl;
+        } else {
+            cout << "Queues: " << fair_share_queues << endl;
+        }
     } catch (const exception& e) {
         cerr << e.what() << endl;
         return EXIT_FAILURE;
     }
 
     // Read error codes from JSON file using the input argument
-    ifstream file(input_file);
-    if (!file.is_open()) {
-        cerr << "Error: Could not open " << input_file << endl;
+    ErrorCodeTable dictionary;
+    try {
+        dictionary = loadErrorCodes(input_file);
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    // With --queues, every group gets the error codes of its own queue.
+    vector<pair<string, double>> queue_shares;
+    try {
+        queue_shares = parseQueueShares(fair_share_queues);
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
         return EXIT_FAILURE;
     }
-    json j;
-    file >> j;
-    if (!file) {
-        cerr << "Error: Failed to parse " << input_file << endl;
+    if (queue_shares.empty()) {
+        queue_shares.emplace_back(queue_name, 1.0);
+    }
+
+    // Extract error codes and counts for the target sites
+    map<string, int> errorCodes;
+    for (const auto& [queue, share] : queue_shares) {
+        if (dictionary.count(queue) > 0) {
+            for (const auto& [code, count] : dictionary[queue]) {
+                errorCodes[code] += count;
+            }
+        } else {
+            cout << "Site not found: " << queue << endl;
+        }
+    }
+
+    // Create the error code generator
+    g_errorCodeGenerator = new ErrorCodeGenerator(errorCodes);
+    ErrorRegimeSpec regimes;
+    if (!error_regimes_file.empty()) {
+        try {
+            regimes = loadErrorRegimes(error_regimes_file);
+            if (fair_share_queues.empty()) {
+                g_errorRegimes = new TimeVaryingErrorGenerator(regimes, errorCodes);
+            }
+        } catch (const exception& e) {
+            cerr << e.what() << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Retryable error codes are checked against the historical codes of the queues.
+    try {
+        g_retryPolicy = parseRetryPolicy(retry_max_attempts, retry_backoff, retry_backoff_factor, retry_codes, errorCodes);
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
         return EXIT_FAILURE;
     }
 
-    // Convert the JSON data to a dictionary
-    map<string, map<string, int>> dictionary;
+    // Cluster size and dispatch tree.
+    try {
+        if (!num_workers.empty()) {
+            g_numWorkers = stoi(num_workers);
+        }
+        if (!dispatch_fanout.empty()) {
+            g_dispatchTree.fanout = stoi(dispatch_fanout);
+        }
+    } catch (const logic_error& e) {
+        cerr << "Error: Invalid value for --workers or --dispatch-fanout." << endl;
+        return EXIT_FAILURE;
+    }
+    if (g_numWorkers < 1) {
+        cerr << "Error: --workers must be positive." << endl;
+        return EXIT_FAILURE;
+    }
+    if (g_dispatchTree.fanout < 0 || g_dispatchTree.fanout > g_numWorkers) {
+        cerr << "Error: --dispatch-fanout must be between 0 and the number of workers." << endl;
+        return EXIT_FAILURE;
+    }
 
-    for (const auto& [site_name, codes] : j.items()) {
-        for (const auto& [code, count] : codes.items()) {
-            dictionary[site_name][code] = count;
+    // Dispatch mode.
+    if (dispatch_mode == "pull") {
+        g_dispatchMode = DispatchMode::Pull;
+    } else if (dispatch_mode == "steal") {
+        g_dispatchMode = DispatchMode::Steal;
+    } else if (!dispatch_mode.empty() && dispatch_mode != "push") {
+        cerr << "Error: --dispatch must be push, pull or steal." << endl;
+        return EXIT_FAILURE;
+    }
+    try {
+        if (!steal_backoff.empty()) {
+            g_stealing.backoff = stod(steal_backoff);
+        }
+    } catch (const logic_error& e) {
+        cerr << "Error: Invalid value for --steal-backoff." << endl;
+        return EXIT_FAILURE;
+    }
+    if (g_stealing.backoff <= 0) {
+        cerr << "Error: --steal-backoff must be positive." << endl;
+        return EXIT_FAILURE;
+    }
+    try {
+        if (!prefetch_depth.empty()) {
+            g_prefetch.depth = stoi(prefetch_depth);
         }
+    } catch (const logic_error& e) {
+        cerr << "Error: Invalid value for --prefetch." << endl;
+        return EXIT_FAILURE;
+    }
+    if (g_prefetch.depth < 0) {
+        cerr << "Error: --prefetch must not be negative." << endl;
+        return EXIT_FAILURE;
     }
 
-    // Extract error codes and counts for the target site
-    map<string, int> errorCodes;
-    if (dictionary.count(queue_name) > 0) {
-        for (const auto& [code, count] : dictionary[queue_name]) {
-            errorCodes[code] = count;
+    // Task DAGs: --n tasks of the given stage chain.
+    if (!task_chain.empty()) {
+        try {
+            g_tasks.dag = new JobDag(parseTaskChain(task_chain), max(total_jobs, 0));
+        } catch (const exception& e) {
+            cerr << e.what() << endl;
+            return EXIT_FAILURE;
         }
-    } else {
-        cout << "Site not found: " << queue_name << endl;
+        if (g_tasks.dag->nodes() > numeric_limits<int>::max()) {
+            cerr << "Error: --task-chain with --n " << total_jobs << " has too many jobs." << endl;
+            return EXIT_FAILURE;
+        }
+        g_tasks.remaining.assign(g_tasks.dag->tasks(), static_cast<int>(g_tasks.dag->jobsPerTask()));
+        g_tasks.submit.assign(g_tasks.dag->tasks(), 0.0);
+        g_tasks.failed.assign(g_tasks.dag->tasks(), false);
+        total_jobs = static_cast<int>(g_tasks.dag->nodes());
+        cout << "Task chain: " << task_chain << " (" << g_tasks.dag->jobsPerTask() << " jobs per task, "
+             << total_jobs << " jobs)" << endl;
     }
 
-    // Create the error code generator
-    g_errorCodeGenerator = new ErrorCodeGenerator(errorCodes);
+    // Host outage parameters.
+    try {
+        if (!host_mtbf.empty()) {
+            g_outages.mtbf = stod(host_mtbf);
+        }
+        if (!host_mttr.empty()) {
+            g_outages.mttr = stod(host_mttr);
+        }
+    } catch (const logic_error& e) {
+        cerr << "Error: Invalid value for --mtbf or --mttr." << endl;
+        return EXIT_FAILURE;
+    }
+    if (g_outages.mtbf < 0 || g_outages.mttr <= 0) {
+        cerr << "Error: --mtbf must not be negative and --mttr must be positive." << endl;
+        return EXIT_FAILURE;
+    }
+
+    // Pilot parameters.
+    try {
+        if (!pilot_lifetime.empty()) {
+            g_pilotPool.lifetime = stod(pilot_lifetime);
+        }
+        if (!pilot_startup.empty()) {
+            g_pilotPool.startup = stod(pilot_startup);
+        }
+        if (!fetch_overhead.empty()) {
+            g_pilotPool.fetch_overhead = stod(fetch_overhead);
+        }
+        if (!payload_walltime.empty()) {
+            g_pilotPool.payload_walltime = stod(payload_walltime);
+        }
+    } catch (const logic_error& e) {
+        cerr << "Error: Invalid value for a pilot option." << endl;
+        return EXIT_FAILURE;
+    }
+    if (g_pilotPool.lifetime < 0 || g_pilotPool.startup < 0 || g_pilotPool.fetch_overhead < 0 || g_pilotPool.payload_walltime <= 0) {
+        cerr << "Error: Pilot times must not be negative and --payload-walltime must be positive." << endl;
+        return EXIT_FAILURE;
+    }
+    if (pilotMode() && g_pilotPool.lifetime < g_pilotPool.startup + g_pilotPool.fetch_overhead + g_pilotPool.payload_walltime) {
+        cerr << "Error: --pilot-lifetime must cover the pilot startup, one fetch and one payload walltime." << endl;
+        return EXIT_FAILURE;
+    }
+
+    // Autoscaling and arrival parameters.
+    try {
+        if (!autoscale_min.empty()) {
+            g_instancePool.min_instances = stoi(autoscale_min);
+        }
+        if (!autoscale_max.empty()) {
+            g_instancePool.max_instances = stoi(autoscale_max);
+        }
+        if (!boot_time.empty()) {
+            g_instancePool.boot_time = stod(boot_time);
+        }
+        if (!scale_interval.empty()) {
+            g_instancePool.scale_interval = stod(scale_interval);
+        }
+        if (!scale_down_delay.empty()) {
+            g_instancePool.scale_down_delay = stod(scale_down_delay);
+        }
+        if (!jobs_per_instance.empty()) {
+            g_instancePool.jobs_per_instance = stod(jobs_per_instance);
+        }
+        if (!instance_cost.empty()) {
+            g_instancePool.cost = stod(instance_cost);
+        }
+        if (!arrival_rate.empty()) {
+            g_arrivalRate = stod(arrival_rate);
+        }
+        if (!burst_size.empty()) {
+            g_burstSize = stod(burst_size);
+        }
+    } catch (const logic_error& e) {
+        cerr << "Error: Invalid value for an autoscaling or arrival option." << endl;
+        return EXIT_FAILURE;
+    }
+    if (g_instancePool.max_instances < 0 || g_instancePool.max_instances > g_numWorkers) {
+        cerr << "Error: --autoscale-max must be between 0 and " << g_numWorkers << "." << endl;
+        return EXIT_FAILURE;
+    }
+    if (autoscaling() && (g_instancePool.min_instances < 0 || g_instancePool.min_instances > g_instancePool.max_instances)) {
+        cerr << "Error: --autoscale-min must be between 0 and --autoscale-max." << endl;
+        return EXIT_FAILURE;
+    }
+    if (g_instancePool.boot_time < 0 || g_instancePool.scale_interval <= 0 || g_instancePool.scale_down_delay < 0 || g_instancePool.jobs_per_instance <= 0 || g_instancePool.cost < 0) {
+        cerr << "Error: Autoscaling times and costs must not be negative, and --scale-interval and --jobs-per-instance must be positive." << endl;
+        return EXIT_FAILURE;
+    }
+    for (const ModeConflict& conflict : MODE_CONFLICTS) {
+        if (modeEnabled(conflict.a) && modeEnabled(conflict.b)) {
+            cerr << "Error: " << modeOption(conflict.a) << " cannot be combined with " << modeOption(conflict.b) << ": "
+                 << conflict.reason << "." << endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (g_arrivalRate < 0 || g_burstSize < 1) {
+        cerr << "Error: --arrival-rate must not be negative and --burst-size must be at least 1." << endl;
+        return EXIT_FAILURE;
+    }
+    g_unfinishedJobs = total_jobs;
+
+    // Load the per-error-code failure timing, if any.
+    try {
+        g_failureTiming = failure_timing_file.empty() ? new FailureTimingModel() : new FailureTimingModel(failure_timing_file);
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    // Load the job length model, using the parameters of this queue if the file has any.
+    try {
+        JobLengthConfig lengths = job_length_model.empty() ? JobLengthConfig() : JobLengthConfig(job_length_model);
+        g_jobLength = new JobLengthSampler(lengths.forQueue(queue_name));
+        if (!fair_share_queues.empty()) {
+            // Every group follows its own regime chain, so their error bursts are independent.
+            vector<double> shares;
+            for (const auto& [queue, share] : queue_shares) {
+                JobGroup group;
+                group.name = queue;
+                group.errors = new ErrorCodeGenerator(dictionary[queue]);
+                if (!regimes.regimes.empty()) {
+                    group.regimes = new TimeVaryingErrorGenerator(regimes, dictionary[queue]);
+                }
+                group.lengths = new JobLengthSampler(lengths.forQueue(queue));
+                g_groups.push_back(move(group));
+                shares.push_back(share);
+            }
+            double half_life = 86400.0;
+            try {
+                if (!fair_share_half_life.empty()) {
+                    half_life = stod(fair_share_half_life);
+                }
+            } catch (const logic_error& e) {
+                throw runtime_error("Error: Invalid value for --fair-share-half-life.");
+            }
+            if (half_life < 0) {
+                throw runtime_error("Error: --fair-share-half-life must not be negative.");
+            }
+            g_fairShare = FairShare(shares, half_life);
+        }
+        if (!input_size_model.empty()) {
+            g_inputSize = new JobLengthSampler(parseJobLengthSpec(input_size_model), 0.0);
+        }
+        if (!output_size_model.empty()) {
+            g_outputSize = new JobLengthSampler(parseJobLengthSpec(output_size_model), 0.0);
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
 
     // Initialize the SimGrid endgine
     Engine e(&argc, argv);
-    e.load_platform("platform.xml");
+    if (energy_enabled) {
+        sg_host_energy_plugin_init();
+    }
+    // platform.xml only has routes from worker0, so the worker-to-worker traffic of stealing and of sub-dispatchers
+    // needs the cluster built in code, with the 20 hosts of platform.xml unless --workers is given.
+    if (num_workers.empty() && g_dispatchTree.fanout == 0 && g_dispatchMode != DispatchMode::Steal) {
+        e.load_platform("platform.xml");
+    } else {
+        createClusterPlatform(g_numWorkers);
+    }
 
-    // Create the master actor on host "worker0", passing num_jobs via a lambda.
-    Actor::create("master", Host::by_name("worker0"), [total_jobs]() { master(total_jobs); });
-    
-    // Create some worker actors, each bound to its corresponding host.
-    for (int i = 0; i < MAX_WORKERS; i++) {
+    // Resolve the worker hosts and their mailboxes once.
+    g_workerHosts.reserve(g_numWorkers);
+    g_workerMailboxes.reserve(g_numWorkers);
+    for (int i = 0; i < g_numWorkers; i++) {
         string host_name = "worker" + to_string(i);
-        Actor::create(host_name, Host::by_name(host_name), worker);
+        g_workerHosts.push_back(Host::by_name(host_name));
+        g_workerMailboxes.push_back(Mailbox::by_name(host_name));
+    }
+    g_allWorkers.count = g_numWorkers;
+    // Shards are as even as possible; the first ones get one worker more.
+    for (int i = 0, first = 0; i < g_dispatchTree.fanout; i++) {
+        Shard shard;
+        shard.workers.first = first;
+        shard.workers.count = g_numWorkers / g_dispatchTree.fanout + (i < g_numWorkers % g_dispatchTree.fanout ? 1 : 0);
+        shard.mailbox = Mailbox::by_name("dispatcher-" + to_string(i));
+        first += shard.workers.count;
+        g_dispatchTree.shards.push_back(shard);
+    }
+    g_runningJobs.assign(g_numWorkers, nullptr);
+    g_runningSince.assign(g_numWorkers, 0.0);
+    g_runningEnergy.assign(g_numWorkers, 0.0);
+    g_pilotPool.since.assign(g_numWorkers, -1.0);
+    g_instancePool.since.assign(g_numWorkers, -1.0);
+    g_prefetch.slots.assign(g_numWorkers, vector<Job*>(g_prefetch.depth + 1, nullptr));
+
+    if (resubmissionEnabled()) {
+        g_retryAvailable = Semaphore::create(0);
+    }
+    g_allJobsDone = Semaphore::create(0);
+    if (pilotMode() || autoscaling() || fairShareEnabled() || g_dispatchMode == DispatchMode::Pull) {
+        g_jobsAvailable = Semaphore::create(0);
+    }
+    if (g_dispatchMode == DispatchMode::Steal) {
+        g_stealing.local_queues.resize(g_numWorkers);
+        g_stealing.in_flight.assign(g_numWorkers, nullptr);
+        for (int i = 0; i < g_numWorkers; i++) {
+            g_stealing.local_available.push_back(Semaphore::create(0));
+            g_stealing.requests.push_back(Mailbox::by_name("steal-" + to_string(i)));
+            g_stealing.replies.push_back(Mailbox::by_name("steal-reply-" + to_string(i)));
+        }
+    }
+
+    // Open the optional binary event log; records are buffered and written in large chunks.
+    if (!event_log_file.empty()) {
+        try {
+            g_eventLog = new JobEventLog(event_log_file);
+        } catch (const exception& e) {
+            cerr << e.what() << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Pick the actor instantiation once; a quiet build (SIM_LOG_LEVEL=0) never instantiates the verbose one.
+    if constexpr (kLoggingCompiledIn) {
+        if (muted)
+            create_actors<false>(total_jobs);
+        else
+            create_actors<true>(total_jobs);
+    } else {
+        create_actors<false>(total_jobs);
     }
 
     e.run();
 
+    // A failed write of the event log still prints the summary, but fails the run.
+    bool event_log_failed = false;
+    if (g_eventLog) {
+        try {
+            g_eventLog->close();
+            cout << "Event log written to " << event_log_file << endl;
+        } catch (const exception& ex) {
+            cerr << ex.what() << " " << event_log_file << endl;
+            event_log_failed = true;
+        }
+        delete g_eventLog;
+        g_eventLog = nullptr;
+    }
+
     // After simulation run is finished, print a summary.
     cout << "\n=== Simulation Summary ===" << endl;
     int total_success = g_total_success;
@@ -313,7 +1918,270 @@ int main(int argc, char* argv[]) {
             cout << "  Error code " << kv.first << ": " << kv.second << endl;
         }
     }
+    if (!g_wasted_time.empty()) {
+        double total_wasted = 0.0;
+        cout << "Wasted CPU time by error code:" << endl;
+        for (const auto& kv : g_wasted_time) {
+            cout << "  Error code " << kv.first << ": " << kv.second / 3600.0 << " h" << endl;
+            total_wasted += kv.second;
+        }
+        cout << "Wasted CPU time: " << total_wasted / 3600.0 << " h" << endl;
+    }
+    if (energy_enabled) {
+        // The total includes idle hosts and staging, so the energy per successful job is what a useful job costs the
+        // site; the energy of the successful attempts alone is what the jobs themselves used.
+        double total_energy = 0.0;
+        for (Host* host : g_workerHosts) {
+            total_energy += sg_host_get_consumed_energy(host);
+        }
+        double wasted_energy = 0.0;
+        for (const auto& kv : g_wasted_energy) {
+            wasted_energy += kv.second;
+        }
+        cout << "Energy consumed: " << total_energy / 3.6e6 << " kWh" << endl;
+        cout << "Energy on successful jobs: " << g_success_energy / 1e3 << " kJ";
+        if (total_success > 0) {
+            cout << " (" << g_success_energy / total_success << " J per job)";
+        }
+        cout << endl;
+        if (total_success > 0) {
+            cout << "Energy per successful job, including idle hosts and failed attempts: " << total_energy / total_success << " J" << endl;
+        }
+        if (!g_wasted_energy.empty()) {
+            cout << "Wasted energy by error code:" << endl;
+            for (const auto& kv : g_wasted_energy) {
+                cout << "  Error code " << kv.first << ": " << kv.second / 1e3 << " kJ" << endl;
+            }
+        }
+        cout << "Wasted energy: " << wasted_energy / 1e3 << " kJ";
+        if (total_energy > 0) {
+            cout << " (" << 100.0 * wasted_energy / total_energy << "% of the total)";
+        }
+        cout << endl;
+        if (g_outages.mtbf > 0) {
+            cout << "Energy lost with failed hosts: " << g_lost_energy / 1e3 << " kJ" << endl;
+        }
+    }
+    if (g_inputSize || g_outputSize) {
+        double sim_seconds = Engine::get_clock();
+        cout << "Data staged in: " << g_bytes_in / 1e9 << " GB in " << g_stage_in_time / 3600.0 << " h" << endl;
+        cout << "Data staged out: " << g_bytes_out / 1e9 << " GB in " << g_stage_out_time / 3600.0 << " h" << endl;
+        if (g_attempts > 0) {
+            cout << "Staging time per attempt: " << (g_stage_in_time + g_stage_out_time) / g_attempts << " s" << endl;
+        }
+        // All routes in platform.xml share the link "lnk" of worker0.
+        Link* link = Link::by_name_or_null("lnk");
+        if (link && sim_seconds > 0) {
+            cout << "Storage link utilization: " << 100.0 * g_link_bytes / (link->get_bandwidth() * sim_seconds) << "%" << endl;
+        }
+    }
+    if (!regimes.regimes.empty()) {
+        // With --queues, the regime counts are summed over the groups.
+        vector<TimeVaryingErrorGenerator*> generators;
+        if (g_errorRegimes) {
+            generators.push_back(g_errorRegimes);
+        }
+        for (const JobGroup& group : g_groups) {
+            generators.push_back(group.regimes);
+        }
+        long switches = 0;
+        for (const TimeVaryingErrorGenerator* generator : generators) {
+            switches += generator->switches();
+        }
+        cout << "Error regimes (" << switches << " regime changes):" << endl;
+        for (size_t r = 0; r < regimes.regimes.size(); r++) {
+            long draws = 0, failures = 0;
+            for (const TimeVaryingErrorGenerator* generator : generators) {
+                draws += generator->draws(r);
+                failures += generator->failures(r);
+            }
+            cout << "  " << regimes.regimes[r].name << ": " << draws << " jobs, failure rate "
+                 << (draws > 0 ? 100.0 * failures / draws : 0.0) << "%" << endl;
+        }
+    }
+    if (fairShareEnabled()) {
+        // Usage share is the fraction of all CPU time a group received; it approaches its target while all groups
+        // have jobs waiting.
+        double total_cpu = 0.0, total_share = 0.0;
+        for (size_t g = 0; g < g_groups.size(); g++) {
+            total_cpu += g_groups[g].cpu_time;
+            total_share += g_fairShare.share(static_cast<int>(g));
+        }
+        cout << "Fair share (usage half-life " << (fair_share_half_life.empty() ? "86400" : fair_share_half_life) << " s):" << endl;
+        cout << left << setw(26) << "  Queue" << right << setw(10) << "Target" << setw(10) << "Usage" << setw(10) << "Success"
+             << setw(10) << "Failed" << setw(12) << "CPU [h]" << setw(12) << "Wait [s]" << setw(14) << "Finished [s]" << endl;
+        for (size_t g = 0; g < g_groups.size(); g++) {
+            const JobGroup& group = g_groups[g];
+            cout << left << setw(26) << "  " + group.name << right << fixed << setprecision(4)
+                 << setw(10) << g_fairShare.share(static_cast<int>(g)) / total_share
+                 << setw(10) << (total_cpu > 0 ? group.cpu_time / total_cpu : 0.0)
+                 << setw(10) << group.succeeded << setw(10) << group.failed << setprecision(2)
+                 << setw(12) << group.cpu_time / 3600.0
+                 << setw(12) << (group.started > 0 ? group.wait_time / group.started : 0.0)
+                 << setw(14) << group.last_end << defaultfloat << endl;
+        }
+    }
+    if (g_dispatchTree.fanout > 0 || !num_workers.empty() || !prefetch_depth.empty()) {
+        cout << "Dispatch: " << g_numWorkers << " workers, ";
+        if (g_dispatchTree.fanout > 0) {
+            cout << g_dispatchTree.fanout << " sub-dispatchers with " << g_numWorkers / g_dispatchTree.fanout << " or more workers each" << endl;
+        } else {
+            cout << "dispatched by the master" << endl;
+        }
+        if (g_handoffs > 0) {
+            cout << "Dispatch latency: mean " << g_dispatch_latency / g_handoffs << " s from creation to a worker, last job handed out after "
+                 << g_last_handoff << " s" << endl;
+        }
+        if (!prefetch_depth.empty()) {
+            cout << "Prefetch depth: " << g_prefetch.depth << " jobs, workers waited " << g_prefetch.receive_wait / 3600.0 << " h for their next job" << endl;
+        }
+    }
+    if (g_outages.mtbf > 0) {
+        double sim_seconds = Engine::get_clock();
+        int failing_hosts = 0;
+        for (int i = 0; i < g_numWorkers; i++) {
+            failing_hosts += neverFails(i) ? 0 : 1;
+        }
+        double host_seconds = sim_seconds * failing_hosts;
+        cout << "Host outages: MTBF " << g_outages.mtbf << " s, MTTR " << g_outages.mttr << " s" << endl;
+        cout << "Host failures: " << g_outages.failures << ", downtime: " << g_outages.downtime / 3600.0 << " h";
+        if (host_seconds > 0) {
+            cout << " (availability " << 100.0 * (1.0 - g_outages.downtime / host_seconds) << "%)";
+        }
+        cout << endl;
+        cout << "Jobs lost with failed hosts: " << g_outages.lost_jobs << ", lost CPU time: " << g_outages.lost_time / 3600.0 << " h" << endl;
+        if (sim_seconds > 0) {
+            cout << "Throughput: " << total_success / (sim_seconds / 3600.0) << " successful jobs per simulated hour" << endl;
+        }
+    }
+    if (pilotMode()) {
+        // Pilots still holding their slot at the end count up to the end of the simulation.
+        double sim_seconds = Engine::get_clock();
+        for (double since : g_pilotPool.since) {
+            if (since >= 0) {
+                g_pilotPool.slot_time += sim_seconds - since;
+            }
+        }
+        cout << "Pilots: lifetime " << g_pilotPool.lifetime << " s, startup " << g_pilotPool.startup << " s, fetch overhead "
+             << g_pilotPool.fetch_overhead << " s, payload walltime " << g_pilotPool.payload_walltime << " s" << endl;
+        cout << "Pilots started: " << g_pilotPool.pilots << ", payload fetches: " << g_pilotPool.fetches << " (" << g_pilotPool.empty_fetches
+             << " without a payload)" << endl;
+        cout << "Slot time: " << g_pilotPool.slot_time / 3600.0 << " h, payload time: " << g_pilotPool.payload_time / 3600.0 << " h" << endl;
+        if (g_pilotPool.slot_time > 0) {
+            cout << "Pilot efficiency: " << 100.0 * g_pilotPool.payload_time / g_pilotPool.slot_time << "%" << endl;
+        }
+        cout << "Payloads that ran past their pilot's lifetime: " << g_pilotPool.overruns << endl;
+        if (sim_seconds > 0) {
+            cout << "Throughput: " << total_success / (sim_seconds / 3600.0) << " successful jobs per simulated hour" << endl;
+        }
+    }
+    if (autoscaling()) {
+        // Instances still running at the end are billed up to the end of the simulation.
+        double sim_seconds = Engine::get_clock();
+        for (double since : g_instancePool.since) {
+            if (since >= 0) {
+                g_instancePool.instance_time += sim_seconds - since;
+            }
+        }
+        double cost = g_instancePool.instance_time / 3600.0 * g_instancePool.cost;
+        cout << "Autoscaling: " << g_instancePool.min_instances << " to " << g_instancePool.max_instances << " instances, boot time " << g_instancePool.boot_time
+             << " s, scale interval " << g_instancePool.scale_interval << " s, scale-down delay " << g_instancePool.scale_down_delay << " s" << endl;
+        cout << "Instances started: " << g_instancePool.started << ", peak: " << g_instancePool.peak;
+        if (sim_seconds > 0) {
+            cout << ", mean: " << g_instancePool.instance_time / sim_seconds;
+        }
+        cout << endl;
+        cout << "Instance time: " << g_instancePool.instance_time / 3600.0 << " h, busy: " << g_instancePool.busy_time / 3600.0 << " h";
+        if (g_instancePool.instance_time > 0) {
+            cout << " (utilization " << 100.0 * g_instancePool.busy_time / g_instancePool.instance_time << "%)";
+        }
+        cout << endl;
+        cout << "Cost: $" << cost << " at $" << g_instancePool.cost << " per instance-hour" << endl;
+        if (cost > 0) {
+            cout << "Throughput per dollar: " << total_success / cost << " successful jobs per $" << endl;
+        }
+        if (sim_seconds > 0) {
+            cout << "Throughput: " << total_success / (sim_seconds / 3600.0) << " successful jobs per simulated hour" << endl;
+        }
+    }
+    if (!g_latencies.empty()) {
+        // Latency runs from the arrival of a job to its final state, over all its attempts.
+        sort(g_latencies.begin(), g_latencies.end());
+        double sum = 0.0;
+        for (double latency : g_latencies) {
+            sum += latency;
+        }
+        auto percentile = [](double p) { return g_latencies[static_cast<size_t>(p * (g_latencies.size() - 1))]; };
+        if (g_arrivalRate > 0) {
+            cout << "Arrivals: " << g_arrivalRate << " jobs per second in bursts of " << g_burstSize << " jobs on average" << endl;
+        }
+        cout << "Job latency: mean " << sum / g_latencies.size() << " s, median " << percentile(0.5) << " s, 95th percentile "
+             << percentile(0.95) << " s, 99th percentile " << percentile(0.99) << " s, max " << g_latencies.back() << " s" << endl;
+        cout << "Makespan: " << g_last_end << " s" << endl;
+    }
+    if (g_tasks.dag) {
+        // Cancelled jobs never ran; they are counted among the failed jobs above.
+        cout << "Tasks: " << g_tasks.dag->tasks() << " (" << task_chain << "), succeeded: " << g_tasks.times.size()
+             << ", failed: " << g_tasks.failed_tasks << ", jobs cancelled after a failed parent: " << g_tasks.cancelled_jobs << endl;
+        if (!g_tasks.times.empty()) {
+            // Task completion time runs from the arrival of a task to the end of its last job.
+            sort(g_tasks.times.begin(), g_tasks.times.end());
+            double sum = 0.0;
+            for (double t : g_tasks.times) {
+                sum += t;
+            }
+            auto percentile = [](double p) { return g_tasks.times[static_cast<size_t>(p * (g_tasks.times.size() - 1))]; };
+            cout << "Task completion time: mean " << sum / g_tasks.times.size() << " s, median " << percentile(0.5)
+                 << " s, 95th percentile " << percentile(0.95) << " s, max " << g_tasks.times.back() << " s" << endl;
+        }
+    }
+    if (g_dispatchMode == DispatchMode::Steal) {
+        cout << "Work stealing: " << g_stealing.steal_requests << " steal requests, " << g_stealing.steals << " successful, " << g_stealing.stolen_jobs
+             << " jobs stolen" << endl;
+    }
+    if (g_retryPolicy.enabled()) {
+        double sim_hours = Engine::get_clock() / 3600.0;
+        cout << "Retry policy: up to " << g_retryPolicy.max_attempts << " attempts, backoff "
+             << g_retryPolicy.backoff << " s (x" << g_retryPolicy.backoff_factor << "), retryable codes: ";
+        if (g_retryPolicy.retryable_codes.empty()) {
+            cout << "all";
+        }
+        for (int code : g_retryPolicy.retryable_codes) {
+            cout << code << " ";
+        }
+        cout << endl;
+        cout << "Attempts: " << g_attempts << " (" << g_retries << " retries)" << endl;
+        cout << "Retry amplification: " << (total_jobs > 0 ? static_cast<double>(g_attempts) / total_jobs : 0.0) << endl;
+        cout << "CPU time: " << g_cpu_time / 3600.0 << " h, of which retries: " << g_retry_cpu_time / 3600.0 << " h";
+        if (g_cpu_time > 0) {
+            cout << " (" << 100.0 * g_retry_cpu_time / g_cpu_time << "%)";
+        }
+        cout << endl;
+        if (sim_hours > 0) {
+            cout << "Effective throughput: " << total_success / sim_hours << " successful jobs per simulated hour" << endl;
+        }
+        cout << "Retried error codes:" << endl;
+        for (const auto& kv : g_retried_error_counts) {
+            cout << "  Error code " << kv.first << ": " << kv.second << endl;
+        }
+        if (fairShareEnabled()) {
+            // Per queue: amplification is attempts per job that reached its final state, success/h the effective
+            // throughput of the queue.
+            cout << "Retries per queue:" << endl;
+            cout << left << setw(26) << "  Queue" << right << setw(10) << "Jobs" << setw(10) << "Attempts" << setw(10) << "Retries"
+                 << setw(10) << "Amplif." << setw(12) << "Retry [h]" << setw(10) << "Retry %" << setw(12) << "Success/h" << endl;
+            for (const JobGroup& group : g_groups) {
+                long jobs = group.succeeded + group.failed;
+                cout << left << setw(26) << "  " + group.name << right << setw(10) << jobs << setw(10) << group.attempts
+                     << setw(10) << group.retries << fixed << setprecision(2)
+                     << setw(10) << (jobs > 0 ? static_cast<double>(group.attempts) / jobs : 0.0)
+                     << setw(12) << group.retry_cpu_time / 3600.0
+                     << setw(10) << (group.cpu_time > 0 ? 100.0 * group.retry_cpu_time / group.cpu_time : 0.0)
+                     << setw(12) << (sim_hours > 0 ? group.succeeded / sim_hours : 0.0) << defaultfloat << endl;
+            }
+        }
+    }
     cout << "==========================\n" << endl;
 
-    return 0;
+    return event_log_failed ? EXIT_FAILURE : 0;
 }
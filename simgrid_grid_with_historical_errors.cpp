@@ -0,0 +1,1352 @@
+#include <simgrid/s4u.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <queue>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "availability_profile.hpp"
+#include "core_packing.hpp"
+#include "error_code_generator.hpp"
+#include "error_regimes.hpp"
+#include "failure_timing.hpp"
+#include "grid_platform.hpp"
+#include "job_length_model.hpp"
+#include "job_records.hpp"
+#include "retry_policy.hpp"
+
+XBT_LOG_NEW_DEFAULT_CATEGORY(simgrid_grid, "SimGrid Multi-Site Grid Example");
+
+using namespace simgrid::s4u;
+using namespace std;
+
+// Compile-time verbosity. Build with -DSIM_LOG_LEVEL=0 to compile the per-job logging out of the
+// worker and master loops entirely (no XBT_* calls and no string formatting per job).
+#ifndef SIM_LOG_LEVEL
+#define SIM_LOG_LEVEL 1
+#endif
+constexpr bool kLoggingCompiledIn = SIM_LOG_LEVEL > 0;
+
+// Use --mute to select the quiet actors at startup.
+bool muted = false;
+
+// A job as sent from the PanDA server to a site.
+struct Job {
+    long id;
+    double load;      // Total simulated processing time required.
+    int error_code;   // 0 means success; nonzero indicates an error.
+    int site;         // Index of the site the job was brokered to.
+    int attempt;      // 1 for the first submission, incremented on every retry.
+    double ready_time;  // Earliest resubmission time of a retried job.
+    double input_size;   // Bytes staged in from the site storage element before the run.
+    double output_size;  // Bytes staged out to the site storage element after a successful run.
+    int cores;           // Cores the job occupies on its host.
+    double memory;       // Host memory the job requests in MB.
+    double walltime;     // Requested walltime: an upper bound on the load, as estimated by the user.
+    long order;          // Arrival order at the site.
+    double queued_time;  // Arrival time at the site.
+    double expected_end;  // Start time plus requested walltime, while the job runs.
+    Job(long i, double l, int s)
+        : id(i), load(l), error_code(0), site(s), attempt(1), ready_time(0.0), input_size(0.0), output_size(0.0),
+          cores(1), memory(0.0), walltime(l), order(0), queued_time(0.0), expected_end(0.0) {}
+};
+
+// Waiting jobs of one shape (cores and memory) at a site, by arrival order and, for backfilling, by requested
+// walltime. Both are ordered sets, so a queue of a million jobs costs a logarithmic number of steps per job.
+struct JobQueue {
+    map<long, Job*> fifo;                 // arrival order -> job
+    set<pair<double, long>> by_walltime;  // (requested walltime, arrival order), only kept with --packing easy
+};
+
+// Per-site state: the site's own error distribution, the mailbox its scheduler receives jobs from, the
+// queue state seen by the brokerage, the free cores and memory of its hosts and the job outcome counters.
+struct Site {
+    SiteSpec spec;
+    unique_ptr<ErrorCodeGenerator> errors;
+    unique_ptr<TimeVaryingErrorGenerator> regimes;  // replaces errors with --error-regimes
+    unique_ptr<JobLengthSampler> lengths;  // load of the jobs brokered to the site
+    double failure_probability = 0.0;  // fraction of nonzero error codes in the historical data
+    Mailbox* mbox = nullptr;
+    vector<Host*> hosts;
+    Host* storage = nullptr;       // storage element host
+    Disk* storage_disk = nullptr;  // its disk, shared by all jobs of the site
+    long queued = 0;   // brokered to the site, not yet started
+    long running = 0;
+    long succeeded = 0;
+    long failed = 0;    // jobs that failed for good at this site
+    long attempts = 0;  // attempts executed at this site, including retries
+    long retried = 0;   // failed attempts that were handed back for resubmission
+    double busy_time_succeeded = 0.0;  // core-seconds spent on successful jobs
+    double busy_time_failed = 0.0;     // core-seconds spent on failed attempts
+    double busy_time_retries = 0.0;    // core-seconds spent on attempts after the first one
+    map<int, long> error_counts;       // error codes of the jobs that failed for good
+    double bytes_in = 0.0;             // bytes staged in from the storage element
+    double bytes_out = 0.0;            // bytes staged out to the storage element
+    double stage_time = 0.0;           // job-seconds spent staging in and out
+
+    // Site scheduler: jobs waiting for cores and memory, by core count and memory request.
+    map<pair<int, double>, JobQueue> pending;
+    long pending_jobs = 0;
+    long arrivals = 0;
+    CorePacker cores;
+    Job* reservation = nullptr;  // wide job the reserved host is drained for
+    int reserved_host = -1;
+    AvailabilityProfile profile;  // expected ends of the running jobs, with --packing easy
+    long backfilled = 0;          // jobs started ahead of an older waiting job
+    long negotiation_cycles = 0;
+
+    // Core accounting, integrated over simulated time.
+    long busy_cores = 0;
+    double last_change = 0.0;
+    double core_busy_time = 0.0;     // core-seconds in use
+    double core_idle_waiting = 0.0;  // core-seconds idle while jobs were waiting
+    double wait_time[2] = {0.0, 0.0};  // queue wait of single-core and multi-core jobs
+    long started[2] = {0, 0};
+    double busy_memory = 0.0;        // MB requested by the running jobs
+    double memory_busy_time = 0.0;   // MB-seconds requested
+    long oom_kills = 0;              // attempts killed for exceeding their memory request
+
+    // Recorded outcomes of the jobs replayed to the site (--replay).
+    long recorded_jobs = 0;
+    long recorded_failed = 0;
+    double recorded_core_time_succeeded = 0.0;  // recorded walltime times cores of the successful records
+    double recorded_core_time_failed = 0.0;     // the same for the failed records
+};
+
+vector<Site> g_sites;
+
+// Failed jobs are resubmitted through the brokerage according to the retry policy. Workers hand
+// retryable failures to the resubmitter actor on the PanDA server, which rebrokers them once their
+// backoff has expired.
+RetryPolicy g_retryPolicy;
+Mailbox* g_retryMailbox = nullptr;
+SemaphorePtr g_allJobsDone;  // released when the last job has reached its final state; the master waits for it
+long g_unfinishedJobs = 0;
+map<int, long> g_retriedErrorCounts;
+
+// Time to failure per error code (--failure-timing) and the CPU time wasted per error code.
+unique_ptr<FailureTimingModel> g_failureTiming;
+map<int, double> g_wastedTimeByCode;
+
+// Sizes of the input and output files of every job in MB (--input-size, --output-size), drawn from the
+// models of job_length_model.hpp. No data is staged without them.
+unique_ptr<JobLengthSampler> g_inputSize;
+unique_ptr<JobLengthSampler> g_outputSize;
+
+// Memory model: with a positive --oom-sigma, the peak memory of every attempt is lognormally distributed around
+// OOM_MEDIAN_USAGE times the request, and an attempt that exceeds its request is killed at a random point of its
+// run with the pilot error code for payloads that exceed their maximum allowed memory.
+double g_oomSigma = 0.0;
+const double OOM_MEDIAN_USAGE = 0.7;
+const int OOM_ERROR_CODE = 1212;
+
+// Packing of jobs onto the cores of the hosts of a site (--packing): first-fit takes the lowest-numbered host
+// with enough free cores, best-fit the host with the fewest free cores that still fit, and reservation is
+// first-fit where the oldest waiting multi-core job drains the host with the most free cores, which then
+// takes no other jobs until it fits. The batch system models are easy, FIFO with EASY backfilling on the
+// requested walltime, and condor, HTCondor-like matchmaking in periodic negotiation cycles.
+enum class Packing { FirstFit, BestFit, Reservation, Easy, Condor };
+Packing g_packing = Packing::FirstFit;
+const char* const PACKING_POLICIES = "first-fit, best-fit, reservation, easy, condor";
+double g_negotiationInterval = 60.0;  // seconds between negotiation cycles with --packing condor
+
+// Replay of per-job records (--replay <file>, see job_records.hpp): every record becomes a job at its recorded site,
+// submitted at its recorded time relative to the first record, with its recorded cores. The walltime of a successful
+// record is the full length of the job and becomes its load; that of a failed record is only its time to failure, so
+// those jobs draw their load from the job length model of the site. The record file is streamed while the simulation
+// runs. Outcomes are drawn as for any other job, and the summary compares them with the recorded ones.
+long g_replayedJobs = 0;
+long g_skippedRecords = 0;  // records of sites that are not part of the grid
+double g_recordedEnd = 0.0;  // latest recorded submit time plus walltime, relative to the first record
+map<int, long> g_recordedErrorCounts;
+string g_replayError;       // why the replay stopped early, empty if it read the whole file
+long g_replayErrorLine = 0;  // line of the record file it stopped at
+
+Packing parsePacking(const string& name) {
+    if (name == "first-fit")
+        return Packing::FirstFit;
+    if (name == "best-fit")
+        return Packing::BestFit;
+    if (name == "reservation")
+        return Packing::Reservation;
+    if (name == "easy")
+        return Packing::Easy;
+    if (name == "condor")
+        return Packing::Condor;
+    throw runtime_error("Error: Unknown packing policy " + name + " (expected one of: " + PACKING_POLICIES + ")");
+}
+
+
+// Brokerage policy: picks the site each new job is sent to, based on the queue state of the sites
+// and their historical failure probability.
+class BrokeragePolicy {
+    public:
+        virtual ~BrokeragePolicy() = default;
+        virtual int selectSite(const vector<Site>& sites) = 0;
+};
+
+// Round-robin over all worker slots of the grid: sites receive jobs in proportion to their size.
+class RoundRobinPolicy : public BrokeragePolicy {
+    public:
+        int selectSite(const vector<Site>& sites) override {
+            if (slot_site_.empty()) {
+                for (size_t s = 0; s < sites.size(); s++) {
+                    slot_site_.insert(slot_site_.end(), sites[s].hosts.size(), static_cast<int>(s));
+                }
+            }
+            int site = slot_site_[slot_];
+            if (++slot_ == slot_site_.size()) {
+                slot_ = 0;
+            }
+            return site;
+        }
+
+    private:
+        vector<int> slot_site_;  // slot s of the grid belongs to site slot_site_[s]
+        size_t slot_ = 0;
+};
+
+// Sends the job to the site with the fewest queued and running jobs per host.
+class LeastLoadedPolicy : public BrokeragePolicy {
+    public:
+        int selectSite(const vector<Site>& sites) override {
+            int best = 0;
+            double best_load = load(sites[0]);
+            for (size_t s = 1; s < sites.size(); s++) {
+                double l = load(sites[s]);
+                if (l < best_load) {
+                    best = static_cast<int>(s);
+                    best_load = l;
+                }
+            }
+            return best;
+        }
+
+    protected:
+        static double load(const Site& site) {
+            return static_cast<double>(site.queued + site.running + 1) / site.hosts.size();
+        }
+};
+
+// Minimizes the expected load per successful job: the queue depth per host divided by the
+// probability that the job succeeds at the site.
+class ReliabilityPolicy : public LeastLoadedPolicy {
+    public:
+        int selectSite(const vector<Site>& sites) override {
+            int best = 0;
+            double best_score = score(sites[0]);
+            for (size_t s = 1; s < sites.size(); s++) {
+                double sc = score(sites[s]);
+                if (sc < best_score) {
+                    best = static_cast<int>(s);
+                    best_score = sc;
+                }
+            }
+            return best;
+        }
+
+    private:
+        static double score(const Site& site) {
+            return load(site) / max(1e-6, 1.0 - site.failure_probability);
+        }
+};
+
+// PanDA-like weighted random choice: the weight of a site grows with its size and success
+// probability and shrinks with its queue depth per host.
+class WeightedRandomPolicy : public BrokeragePolicy {
+    public:
+        WeightedRandomPolicy() : gen_(random_device{}()) {}
+
+        int selectSite(const vector<Site>& sites) override {
+            weights_.resize(sites.size());
+            double total = 0.0;
+            for (size_t s = 0; s < sites.size(); s++) {
+                const Site& site = sites[s];
+                double hosts = static_cast<double>(site.hosts.size());
+                total += hosts * (1.0 - site.failure_probability) / (1.0 + site.queued / hosts);
+                weights_[s] = total;
+            }
+            double r = uniform_real_distribution<>(0.0, total)(gen_);
+            auto it = upper_bound(weights_.begin(), weights_.end(), r);
+            return static_cast<int>(min<size_t>(it - weights_.begin(), sites.size() - 1));
+        }
+
+    private:
+        mt19937 gen_;
+        vector<double> weights_;  // cumulative weights
+};
+
+const char* const BROKERAGE_POLICIES = "round-robin, least-loaded, reliability, weighted";
+
+unique_ptr<BrokeragePolicy> makeBrokeragePolicy(const string& name) {
+    if (name == "round-robin")
+        return make_unique<RoundRobinPolicy>();
+    if (name == "least-loaded")
+        return make_unique<LeastLoadedPolicy>();
+    if (name == "reliability")
+        return make_unique<ReliabilityPolicy>();
+    if (name == "weighted")
+        return make_unique<WeightedRandomPolicy>();
+    throw runtime_error("Error: Unknown brokerage policy " + name + " (expected one of: " + BROKERAGE_POLICIES + ")");
+}
+
+// Options of the grid example.
+struct GridOptions {
+    string input_file;
+    string catalog_file = "site_catalog.json";
+    long num_jobs = 0;
+    double scale = 1.0;
+    set<string> sites;  // restrict the grid to these sites (all if empty)
+    string policy = "round-robin";
+    double rate = 0.0;  // mean job arrival rate in jobs/s (0: all jobs are submitted at once)
+    string max_attempts, retry_backoff, retry_backoff_factor, retry_codes;  // retry policy, see retry_policy.hpp
+    string failure_timing_file;  // per-error-code time to failure, see failure_timing.hpp
+    string job_length_model;     // default or per-queue job lengths, see job_length_model.hpp
+    string error_regimes_file;   // time-varying error rates, see error_regimes.hpp
+    string input_size_model, output_size_model;  // staged file sizes in MB, see job_length_model.hpp
+    string packing = "first-fit";
+    double multicore_fraction = 0.0;  // fraction of multi-core jobs
+    int multicore_cores = 8;          // cores of a multi-core job
+    int cores = 0;                    // cores per host for all sites (0: as in the catalog)
+    double memory_per_core = 0.0;     // host memory in MB per core for all sites (0: as in the catalog)
+    double job_memory = 2000.0;       // memory request in MB per core
+    double highmem_fraction = 0.0;    // fraction of high-memory jobs
+    double highmem_memory = 4000.0;   // memory request of a high-memory job in MB per core
+    double oom_sigma = 0.0;           // spread of the peak memory (0: jobs never exceed their request)
+    double walltime_factor = 3.0;     // requested walltimes are up to this factor above the load
+    double negotiation_interval = 60.0;
+    string replay_file;               // per-job records to replay instead of generated jobs
+};
+
+// Function to parse command-line arguments
+GridOptions parseArguments(int argc, char* argv[]) {
+    unordered_map<string, string> args;
+
+    // Loop over all arguments.
+    for (int i = 1; i < argc; i++) {
+        string key = argv[i];
+        if (key == "--mute") {
+            muted = true;
+            continue;
+        }
+        // These options require a value.
+        if (key == "--input" || key == "--n" || key == "--catalog" || key == "--scale" || key == "--sites" ||
+            key == "--policy" || key == "--rate" || key == "--max-attempts" || key == "--retry-backoff" ||
+            key == "--retry-backoff-factor" || key == "--retry-codes" || key == "--failure-timing" || key == "--job-length" ||
+            key == "--error-regimes" || key == "--input-size" || key == "--output-size" || key == "--packing" ||
+            key == "--multicore-fraction" || key == "--multicore-cores" || key == "--cores" ||
+            key == "--memory-per-core" || key == "--job-memory" || key == "--highmem-fraction" ||
+            key == "--highmem-memory" || key == "--oom-sigma" || key == "--walltime-factor" ||
+            key == "--negotiation-interval" || key == "--replay") {
+            if (i + 1 >= argc) {
+                throw runtime_error("Error: Missing value for " + key);
+            }
+            args[key] = argv[i + 1];
+            i++; // Skip the value argument.
+        } else {
+            throw runtime_error("Error: Unknown argument " + key);
+        }
+    }
+
+    // Validate required arguments.
+    if (args.find("--input") == args.end()) {
+        throw runtime_error("Error: Missing --input argument.");
+    }
+    // A replay takes its jobs from the record file; --n then optionally limits the number of records.
+    if (args.find("--n") == args.end() && args.find("--replay") == args.end()) {
+        throw runtime_error("Error: Missing --n argument.");
+    }
+
+    GridOptions options;
+    options.input_file = args["--input"];
+    options.replay_file = args["--replay"];
+    if (args.count("--catalog") > 0) {
+        options.catalog_file = args["--catalog"];
+    }
+    if (args.count("--policy") > 0) {
+        options.policy = args["--policy"];
+    }
+    options.max_attempts = args["--max-attempts"];
+    options.retry_backoff = args["--retry-backoff"];
+    options.retry_backoff_factor = args["--retry-backoff-factor"];
+    options.retry_codes = args["--retry-codes"];
+    options.failure_timing_file = args["--failure-timing"];
+    options.job_length_model = args["--job-length"];
+    options.error_regimes_file = args["--error-regimes"];
+    options.input_size_model = args["--input-size"];
+    options.output_size_model = args["--output-size"];
+    if (args.count("--packing") > 0) {
+        options.packing = args["--packing"];
+    }
+    try {
+        if (args.count("--n") > 0) {
+            options.num_jobs = stol(args["--n"]);
+        }
+        if (args.count("--scale") > 0) {
+            options.scale = stod(args["--scale"]);
+        }
+        if (args.count("--rate") > 0) {
+            options.rate = stod(args["--rate"]);
+        }
+        if (args.count("--multicore-fraction") > 0) {
+            options.multicore_fraction = stod(args["--multicore-fraction"]);
+        }
+        if (args.count("--multicore-cores") > 0) {
+            options.multicore_cores = stoi(args["--multicore-cores"]);
+        }
+        if (args.count("--cores") > 0) {
+            options.cores = stoi(args["--cores"]);
+        }
+        if (args.count("--memory-per-core") > 0) {
+            options.memory_per_core = stod(args["--memory-per-core"]);
+        }
+        if (args.count("--job-memory") > 0) {
+            options.job_memory = stod(args["--job-memory"]);
+        }
+        if (args.count("--highmem-fraction") > 0) {
+            options.highmem_fraction = stod(args["--highmem-fraction"]);
+        }
+        if (args.count("--highmem-memory") > 0) {
+            options.highmem_memory = stod(args["--highmem-memory"]);
+        }
+        if (args.count("--oom-sigma") > 0) {
+            options.oom_sigma = stod(args["--oom-sigma"]);
+        }
+        if (args.count("--walltime-factor") > 0) {
+            options.walltime_factor = stod(args["--walltime-factor"]);
+        }
+        if (args.count("--negotiation-interval") > 0) {
+            options.negotiation_interval = stod(args["--negotiation-interval"]);
+        }
+    } catch (const invalid_argument& e) {
+        throw runtime_error("Error: Invalid numeric value for --n, --scale, --rate or a multi-core, memory or batch system option.");
+    } catch (const out_of_range& e) {
+        throw runtime_error("Error: Value for --n, --scale, --rate or a multi-core, memory or batch system option is out of range.");
+    }
+    // Without --rate, all jobs are submitted at once; an explicit rate must be positive.
+    if ((args.count("--n") > 0 && options.num_jobs <= 0) || !(options.scale > 0) ||
+        (args.count("--rate") > 0 && !(options.rate > 0))) {
+        throw runtime_error("Error: --n, --scale and --rate must be positive.");
+    }
+    if (options.walltime_factor < 1 || options.negotiation_interval <= 0) {
+        throw runtime_error("Error: --walltime-factor must be at least 1 and --negotiation-interval positive.");
+    }
+    if (options.multicore_fraction < 0 || options.multicore_fraction > 1 || options.multicore_cores < 1 || options.cores < 0) {
+        throw runtime_error("Error: --multicore-fraction must be between 0 and 1, --multicore-cores at least 1 and --cores positive.");
+    }
+    if (options.highmem_fraction < 0 || options.highmem_fraction > 1 || options.memory_per_core < 0 || options.job_memory < 0 ||
+        options.highmem_memory < 0 || options.oom_sigma < 0) {
+        throw runtime_error("Error: --highmem-fraction must be between 0 and 1 and the other memory options must not be negative.");
+    }
+    if (args.count("--sites") > 0) {
+        stringstream ss(args["--sites"]);
+        string site;
+        while (getline(ss, site, ',')) {
+            if (!site.empty()) {
+                options.sites.insert(site);
+            }
+        }
+    }
+    return options;
+}
+
+
+template <bool Verbose>
+void runJob(int site_index, int host_index, Job* job);
+
+// Integrates the core and memory usage of a site up to now. Called before every change of its cores or its queue.
+void accountCores(Site& site) {
+    double now = Engine::get_clock();
+    double dt = now - site.last_change;
+    site.core_busy_time += site.busy_cores * dt;
+    site.memory_busy_time += site.busy_memory * dt;
+    if (site.pending_jobs > 0) {
+        long total_cores = static_cast<long>(site.hosts.size()) * site.cores.coresPerHost();
+        site.core_idle_waiting += (total_cores - site.busy_cores) * dt;
+    }
+    site.last_change = now;
+}
+
+// Host for a waiting job under the packing policy, or -1 if no host has enough free cores and memory yet.
+int placeJob(const Site& site, const Job* job) {
+    if (job == site.reservation && site.cores.fits(site.reserved_host, job->cores, job->memory)) {
+        return site.reserved_host;
+    }
+    return g_packing == Packing::BestFit ? site.cores.bestFit(job->cores, job->memory)
+                                         : site.cores.firstFit(job->cores, job->memory);
+}
+
+// Whether a job needs more of a host than a single core: several cores, or more than a core's share of memory.
+bool isWideJob(const Site& site, const Job* job) {
+    return job->cores > 1 || job->memory * site.cores.coresPerHost() > site.cores.memoryPerHost();
+}
+
+// Oldest waiting job of a site that arrived after the given one, or nullptr.
+Job* oldestJob(const Site& site, long after = -1) {
+    Job* oldest = nullptr;
+    for (const auto& [shape, queue] : site.pending) {
+        auto it = queue.fifo.upper_bound(after);
+        if (it != queue.fifo.end() && (oldest == nullptr || it->first < oldest->order)) {
+            oldest = it->second;
+        }
+    }
+    return oldest;
+}
+
+// Takes a waiting job off the queue and starts it on a host as a job actor.
+template <bool Verbose>
+void startJob(int site_index, int host, Job* job) {
+    Site& site = g_sites[site_index];
+    accountCores(site);
+    JobQueue& queue = site.pending[{job->cores, job->memory}];
+    queue.fifo.erase(job->order);
+    if (g_packing == Packing::Easy) {
+        queue.by_walltime.erase({job->walltime, job->order});
+        job->expected_end = Engine::get_clock() + job->walltime;
+        site.profile.start(host, job->cores, job->memory, job->expected_end);
+    }
+    site.pending_jobs--;
+    site.cores.allocate(host, job->cores, job->memory);
+    site.busy_cores += job->cores;
+    site.busy_memory += job->memory;
+    int width = job->cores > 1 ? 1 : 0;
+    site.wait_time[width] += Engine::get_clock() - job->queued_time;
+    site.started[width]++;
+    site.queued--;
+    site.running++;
+    Actor::create("job", site.hosts[host], runJob<Verbose>, site_index, host, job);
+}
+
+// FIFO with EASY backfilling: the oldest waiting job starts as soon as it fits. Until then it holds a reservation
+// on the host where it can start earliest according to the requested walltimes of the running jobs (its shadow
+// time), and a later job may only start if it cannot delay it: on another host, within the cores and memory the
+// reserved host has left over at the shadow time, or with a requested walltime that ends before the shadow time.
+// The oldest such job is started first.
+template <bool Verbose>
+void scheduleEasy(int site_index) {
+    Site& site = g_sites[site_index];
+    double now = Engine::get_clock();
+    while (site.pending_jobs > 0) {
+        Job* head = oldestJob(site);
+        int host = site.cores.firstFit(head->cores, head->memory);
+        if (host >= 0) {
+            startJob<Verbose>(site_index, host, head);
+            continue;
+        }
+        auto [shadow_time, shadow_host] = site.profile.shadow(head->cores, head->memory);
+        if (shadow_host < 0) {
+            return;
+        }
+        auto [extra_cores, extra_memory] = site.profile.extra(shadow_host, shadow_time, head->cores, head->memory);
+
+        // Hiding the reserved host leaves first-fit with the hosts a job can take without delaying the head.
+        Job* chosen = nullptr;
+        int chosen_host = -1;
+        site.cores.reserve(shadow_host);
+        for (const auto& [shape, queue] : site.pending) {
+            const auto& [cores, memory] = shape;
+            // Jobs of the head's shape fit nowhere either.
+            if (queue.fifo.empty() || (cores == head->cores && memory == head->memory)) {
+                continue;
+            }
+            Job* candidate = queue.fifo.begin()->second;
+            host = site.cores.firstFit(cores, memory);
+            if (host < 0 && site.cores.fits(shadow_host, cores, memory)) {
+                host = shadow_host;
+                if (cores > extra_cores || memory > extra_memory) {
+                    // Only a job that ends before the shadow time may use the cores reserved for the head.
+                    const auto& [walltime, order] = *queue.by_walltime.begin();
+                    candidate = now + walltime <= shadow_time ? queue.fifo.at(order) : nullptr;
+                }
+            }
+            if (host >= 0 && candidate != nullptr && (chosen == nullptr || candidate->order < chosen->order)) {
+                chosen = candidate;
+                chosen_host = host;
+            }
+        }
+        site.cores.unreserve(shadow_host);
+        if (chosen == nullptr) {
+            return;
+        }
+        if constexpr (Verbose) {
+            XBT_INFO("Scheduler %s: Backfilling job %ld ahead of job %ld (shadow time %f on %s)", site.spec.name.c_str(),
+                     chosen->id, head->id, shadow_time, site.hosts[shadow_host]->get_cname());
+        }
+        site.backfilled++;
+        startJob<Verbose>(site_index, chosen_host, chosen);
+    }
+}
+
+// One HTCondor-like negotiation cycle. Waiting jobs are matched in arrival order, each to the fullest host that
+// still fits it (best fit), which keeps whole hosts free for multi-core jobs. Jobs of the same shape form an
+// autocluster: once one of them does not match, the rest of the autocluster is skipped for this cycle.
+template <bool Verbose>
+void negotiate(int site_index) {
+    Site& site = g_sites[site_index];
+    site.negotiation_cycles++;
+    set<pair<int, double>> rejected;
+    while (true) {
+        Job* next = nullptr;
+        for (const auto& [shape, queue] : site.pending) {
+            if (!queue.fifo.empty() && rejected.count(shape) == 0 &&
+                (next == nullptr || queue.fifo.begin()->first < next->order)) {
+                next = queue.fifo.begin()->second;
+            }
+        }
+        if (next == nullptr) {
+            return;
+        }
+        int host = site.cores.bestFit(next->cores, next->memory);
+        if (host < 0) {
+            rejected.insert({next->cores, next->memory});
+            continue;
+        }
+        startJob<Verbose>(site_index, host, next);
+    }
+}
+
+// Negotiator actor of a site with --packing condor: runs a negotiation cycle every negotiation interval. Negotiators
+// run as daemons and end with the master.
+template <bool Verbose>
+void negotiator(int site_index) {
+    while (true) {
+        this_actor::sleep_for(g_negotiationInterval);
+        negotiate<Verbose>(site_index);
+    }
+}
+
+// Starts waiting jobs of a site while they fit. Only the head of each per-shape queue is a candidate,
+// since the jobs behind it need the same cores and memory; heads are tried oldest first. With the batch
+// system models, EASY backfilling decides instead, or jobs wait for the next negotiation cycle.
+template <bool Verbose>
+void schedule(int site_index) {
+    if (g_packing == Packing::Easy) {
+        scheduleEasy<Verbose>(site_index);
+        return;
+    }
+    if (g_packing == Packing::Condor) {
+        return;
+    }
+    Site& site = g_sites[site_index];
+    while (site.pending_jobs > 0) {
+        Job* chosen = nullptr;
+        int host = -1;
+        long after = -1;
+        while (chosen == nullptr) {
+            Job* next = oldestJob(site, after);
+            if (next == nullptr) {
+                break;
+            }
+            after = next->order;
+            host = placeJob(site, next);
+            if (host >= 0) {
+                chosen = next;
+            } else if (g_packing == Packing::Reservation && isWideJob(site, next) && site.reservation == nullptr) {
+                site.reserved_host = site.cores.mostFree();
+                if (site.reserved_host >= 0) {
+                    site.reservation = next;
+                    site.cores.reserve(site.reserved_host);
+                }
+            }
+        }
+        if (chosen == nullptr) {
+            return;
+        }
+        if (chosen == site.reservation) {
+            site.cores.unreserve(site.reserved_host);
+            site.reservation = nullptr;
+            site.reserved_host = -1;
+        }
+        startJob<Verbose>(site_index, host, chosen);
+    }
+}
+
+// Site scheduler actor: receives the jobs brokered to its site and queues them for the cores and memory of the site's
+// hosts. Schedulers run as daemons and end with the master once every job has finished.
+template <bool Verbose>
+void siteScheduler(int site_index) {
+    Site& site = g_sites[site_index];
+    if constexpr (Verbose) {
+        XBT_INFO("Scheduler %s: Starting with %zu hosts of %d cores and %.0f MB", site.spec.name.c_str(), site.hosts.size(),
+                 site.cores.coresPerHost(), site.cores.memoryPerHost());
+    }
+    while (true) {
+        Job* job = site.mbox->get<Job>();
+        accountCores(site);
+        // A job never asks for more cores or memory than a host of the site has; its memory request shrinks
+        // with its cores.
+        int cores = min(job->cores, site.cores.coresPerHost());
+        job->memory = min(job->memory * cores / job->cores, site.cores.memoryPerHost());
+        job->cores = cores;
+        job->order = site.arrivals++;
+        job->queued_time = Engine::get_clock();
+        JobQueue& queue = site.pending[{job->cores, job->memory}];
+        queue.fifo.emplace_hint(queue.fifo.end(), job->order, job);
+        if (g_packing == Packing::Easy) {
+            queue.by_walltime.emplace(job->walltime, job->order);
+        }
+        site.pending_jobs++;
+        schedule<Verbose>(site_index);
+    }
+}
+
+// Job actor: runs one attempt of a job on the cores it was given, then hands the cores back to the site
+// scheduler. Failures are drawn from the site's own historical error distribution.
+template <bool Verbose>
+void runJob(int site_index, int host_index, Job* job) {
+    Site& site = g_sites[site_index];
+    Host* host = site.hosts[host_index];
+    const char* name = host->get_cname();
+    const Disk* scratch = host->get_disks().front();
+
+    job->error_code = site.regimes ? site.regimes->getNextErrorCode(Engine::get_clock()) : site.errors->getNextErrorCode();
+
+    // An attempt whose peak memory exceeds its request is killed part-way through, whatever it would have done.
+    double oom_fraction = 0.0;
+    if (g_oomSigma > 0) {
+        static mt19937 gen(random_device{}());
+        static lognormal_distribution<> usage(log(OOM_MEDIAN_USAGE), g_oomSigma);
+        if (usage(gen) > 1.0) {
+            job->error_code = OOM_ERROR_CODE;
+            oom_fraction = uniform_real_distribution<>(0.0, 1.0)(gen);
+            site.oom_kills++;
+        }
+    }
+
+    // Stage the input from the storage element disk to the local scratch disk.
+    double stage_start = Engine::get_clock();
+    if (job->input_size > 0) {
+        Io::streamto(site.storage, site.storage_disk, host, scratch, static_cast<uint64_t>(job->input_size));
+        site.bytes_in += job->input_size;
+    }
+
+    // A failed job runs until its error-specific time to failure, so a single sleep covers the whole run.
+    double run_time = job->error_code == 0 ? job->load
+                      : oom_fraction > 0   ? oom_fraction * job->load
+                                           : g_failureTiming->timeToFailure(job->error_code, job->load);
+    this_actor::sleep_for(run_time);
+
+    // Only successful jobs write their output back to the storage element.
+    if (job->output_size > 0 && job->error_code == 0) {
+        Io::streamto(host, scratch, site.storage, site.storage_disk, static_cast<uint64_t>(job->output_size));
+        site.bytes_out += job->output_size;
+    }
+    site.stage_time += Engine::get_clock() - stage_start - run_time;
+    site.running--;
+
+    // Give the cores back; waiting jobs are started once this attempt has been accounted for.
+    accountCores(site);
+    site.cores.release(host_index, job->cores, job->memory);
+    if (g_packing == Packing::Easy) {
+        site.profile.finish(host_index, job->cores, job->memory, job->expected_end);
+    }
+    site.busy_cores -= job->cores;
+    site.busy_memory -= job->memory;
+
+    double core_time = run_time * job->cores;
+    site.attempts++;
+    if (job->attempt > 1) {
+        site.busy_time_retries += core_time;
+    }
+    if (job->error_code != 0) {
+        site.busy_time_failed += core_time;
+        g_wastedTimeByCode[job->error_code] += core_time;
+    }
+    if constexpr (Verbose) {
+        XBT_INFO("Worker %s: Job %ld (attempt %d, %d cores) finished after %f seconds with error code %d",
+                 name, job->id, job->attempt, job->cores, run_time, job->error_code);
+    }
+
+    if (g_retryPolicy.shouldRetry(job->error_code, job->attempt)) {
+        // Hand a retryable failure back to the PanDA server instead of counting it as failed.
+        site.retried++;
+        g_retriedErrorCounts[job->error_code]++;
+        job->ready_time = Engine::get_clock() + g_retryPolicy.delay(job->attempt);
+        job->attempt++;
+        job->error_code = 0;
+        g_retryMailbox->put_async(job, sizeof(Job))->detach();
+    } else {
+        if (job->error_code == 0) {
+            site.succeeded++;
+            site.busy_time_succeeded += core_time;
+        } else {
+            site.failed++;
+            site.error_counts[job->error_code]++;
+        }
+        delete job;
+        if (--g_unfinishedJobs == 0) {
+            g_allJobsDone->release();
+        }
+    }
+    schedule<Verbose>(site_index);
+}
+
+
+// Master actor on the PanDA server: brokers every job to a site chosen by the policy, then waits until every job
+// has finished. All other actors are daemons, so the simulation ends when the master returns. Jobs are sent with detached asynchronous communications and queue up
+// in the site mailboxes. With a positive rate, jobs arrive as a Poisson process instead of all at once.
+template <bool Verbose>
+void master(const GridOptions& options, BrokeragePolicy* policy) {
+    const long num_jobs = options.num_jobs;
+    const double rate = options.rate;
+    if constexpr (Verbose) {
+        XBT_INFO("Master: Starting, dispatching %ld jobs to %zu sites", num_jobs, g_sites.size());
+    }
+
+    mt19937 gen(random_device{}());
+    exponential_distribution<> inter_arrival(rate > 0 ? rate : 1.0);
+    bernoulli_distribution multicore(options.multicore_fraction);
+    bernoulli_distribution highmem(options.highmem_fraction);
+    uniform_real_distribution<> overestimate(1.0, options.walltime_factor);
+    for (long i = 0; i < num_jobs; i++) {
+        if (rate > 0) {
+            this_actor::sleep_for(inter_arrival(gen));
+        }
+        // The load follows the job length model of the queue the job is brokered to.
+        int site = policy->selectSite(g_sites);
+        double job_time = g_sites[site].lengths->next();
+        g_sites[site].queued++;
+        Job* job = new Job(i, job_time, site);
+        if (multicore(gen)) {
+            job->cores = options.multicore_cores;
+        }
+        job->memory = job->cores * (highmem(gen) ? options.highmem_memory : options.job_memory);
+        job->walltime = job_time * overestimate(gen);
+        if (g_inputSize) {
+            job->input_size = g_inputSize->next() * 1e6;
+        }
+        if (g_outputSize) {
+            job->output_size = g_outputSize->next() * 1e6;
+        }
+        g_sites[site].mbox->put_async(job, sizeof(Job))->detach();
+        if constexpr (Verbose) {
+            XBT_INFO("Master: Sent job %ld with load %f to site %s", i, job_time, g_sites[site].spec.name.c_str());
+        }
+    }
+
+    // Jobs keep running (and, with retries, coming back) until every job has succeeded or given up.
+    if (num_jobs > 0) {
+        g_allJobsDone->acquire();
+    }
+    if constexpr (Verbose) {
+        XBT_INFO("Master: All jobs finished. Exiting.");
+    }
+}
+
+
+// Replay master on the PanDA server: streams the record file and submits every record as a job to its recorded site
+// at its recorded submit time, then waits like the master. The number of jobs is only known at the end of the file,
+// so the master holds one unit of g_unfinishedJobs itself until then and the last job cannot end the wait early.
+template <bool Verbose>
+void replayMaster(const GridOptions& options) {
+    if constexpr (Verbose) {
+        XBT_INFO("Master: Starting, replaying %s to %zu sites", options.replay_file.c_str(), g_sites.size());
+    }
+    unordered_map<string, int> site_index;
+    for (size_t s = 0; s < g_sites.size(); s++) {
+        site_index[g_sites[s].spec.name] = static_cast<int>(s);
+    }
+
+    mt19937 gen(random_device{}());
+    bernoulli_distribution highmem(options.highmem_fraction);
+    uniform_real_distribution<> overestimate(1.0, options.walltime_factor);
+    JobRecord record;
+    double first_submit = 0.0;
+    long records = 0;
+    unique_ptr<JobRecordReader> reader;
+    try {
+        reader = make_unique<JobRecordReader>(options.replay_file);
+        while ((options.num_jobs == 0 || records < options.num_jobs) && reader->next(record)) {
+            if (records++ == 0) {
+                first_submit = record.submit_time;
+            }
+            // Records are expected in submit order; a record that is out of order is submitted at once.
+            double submit = record.submit_time - first_submit;
+            if (submit > Engine::get_clock()) {
+                this_actor::sleep_until(submit);
+            }
+            auto it = site_index.find(record.site);
+            if (it == site_index.end()) {
+                g_skippedRecords++;
+                continue;
+            }
+            int site = it->second;
+            Site& s = g_sites[site];
+            s.recorded_jobs++;
+            if (record.error_code != 0) {
+                s.recorded_failed++;
+                s.recorded_core_time_failed += record.walltime * record.cores;
+                g_recordedErrorCounts[record.error_code]++;
+            } else {
+                s.recorded_core_time_succeeded += record.walltime * record.cores;
+            }
+            g_recordedEnd = max(g_recordedEnd, submit + record.walltime);
+
+            s.queued++;
+            double load = record.error_code == 0 ? record.walltime : s.lengths->next();
+            Job* job = new Job(g_replayedJobs++, load, site);
+            job->cores = record.cores;
+            job->memory = job->cores * (highmem(gen) ? options.highmem_memory : options.job_memory);
+            job->walltime = load * overestimate(gen);
+            if (g_inputSize) {
+                job->input_size = g_inputSize->next() * 1e6;
+            }
+            if (g_outputSize) {
+                job->output_size = g_outputSize->next() * 1e6;
+            }
+            g_unfinishedJobs++;
+            s.mbox->put_async(job, sizeof(Job))->detach();
+            if constexpr (Verbose) {
+                XBT_INFO("Master: Sent job %ld with load %f and %d cores to site %s", job->id, load, record.cores,
+                         s.spec.name.c_str());
+            }
+        }
+    } catch (const exception& e) {
+        // A malformed record ends the replay. The jobs submitted so far still run to the end, and main prints the
+        // summary of this partial replay before it reports the error.
+        g_replayError = e.what();
+        g_replayErrorLine = reader ? reader->lineNumber() : 0;
+    }
+
+    if (--g_unfinishedJobs > 0) {
+        g_allJobsDone->acquire();
+    }
+    if constexpr (Verbose) {
+        XBT_INFO("Master: All %ld replayed jobs finished. Exiting.", g_replayedJobs);
+    }
+}
+
+
+// Resubmitter actor on the PanDA server: collects retryable failures from the workers and brokers each
+// one again once its backoff has expired. Pending retries are kept ordered by ready time.
+template <bool Verbose>
+void resubmitter(BrokeragePolicy* policy) {
+    using PendingRetry = pair<double, Job*>;
+    priority_queue<PendingRetry, vector<PendingRetry>, greater<PendingRetry>> pending;
+    while (true) {
+        if (pending.empty()) {
+            Job* job = g_retryMailbox->get<Job>();
+            pending.emplace(job->ready_time, job);
+            continue;
+        }
+        // Keep collecting new retries until the earliest pending one is due.
+        double wait = pending.top().first - Engine::get_clock();
+        if (wait > 0) {
+            try {
+                Job* job = g_retryMailbox->get<Job>(wait);
+                pending.emplace(job->ready_time, job);
+                continue;
+            } catch (const simgrid::TimeoutException&) {
+                // The earliest retry is due now.
+            }
+        }
+        Job* job = pending.top().second;
+        pending.pop();
+        int site = policy->selectSite(g_sites);
+        g_sites[site].queued++;
+        job->site = site;
+        g_sites[site].mbox->put_async(job, sizeof(Job))->detach();
+        if constexpr (Verbose) {
+            XBT_INFO("Resubmitter: Sent job %ld (attempt %d) to site %s", job->id, job->attempt, g_sites[site].spec.name.c_str());
+        }
+    }
+}
+
+
+// Create the master and the site scheduler actors using the quiet or the verbose instantiation.
+template <bool Verbose>
+void create_actors(Host* server, const GridOptions& options, BrokeragePolicy* policy) {
+    if (!options.replay_file.empty()) {
+        Actor::create("master", server, [options]() { replayMaster<Verbose>(options); });
+    } else {
+        Actor::create("master", server, [options, policy]() { master<Verbose>(options, policy); });
+    }
+    if (g_retryPolicy.enabled()) {
+        Actor::create("resubmitter", server, resubmitter<Verbose>, policy)->daemonize();
+    }
+    // The scheduler of a site runs on its storage element host.
+    for (size_t s = 0; s < g_sites.size(); s++) {
+        Actor::create(g_sites[s].spec.name + "-scheduler", g_sites[s].storage, siteScheduler<Verbose>, static_cast<int>(s))->daemonize();
+        if (g_packing == Packing::Condor) {
+            Actor::create(g_sites[s].spec.name + "-negotiator", g_sites[s].storage, negotiator<Verbose>, static_cast<int>(s))->daemonize();
+        }
+    }
+}
+
+
+int main(int argc, char* argv[]) {
+
+    if (argc < 5) {
+        cerr << "Usage: " << argv[0] << " --input <input error file> --n <number of jobs> [--catalog <site catalog>]"
+             << " [--scale <host count factor>] [--sites <site,site,...>] [--policy <brokerage policy>] [--rate <jobs/s>]"
+             << " [--max-attempts <n>] [--retry-backoff <seconds> [--retry-backoff-factor <factor>]] [--retry-codes <code,code,...|all>]"
+             << " [--failure-timing <file>] [--job-length <model|file.json>]"
+             << " [--error-regimes <file>]"
+             << " [--input-size <MB model>] [--output-size <MB model>]"
+             << " [--packing <packing policy>] [--multicore-fraction <f>] [--multicore-cores <n>] [--cores <cores per host>]"
+             << " [--memory-per-core <MB>] [--job-memory <MB per core>] [--highmem-fraction <f>] [--highmem-memory <MB per core>]"
+             << " [--oom-sigma <sigma>] [--walltime-factor <f>] [--negotiation-interval <seconds>]"
+             << " [--replay <job records> (--n then limits the number of records)] [--mute]\n";
+        return 1;
+    }
+
+    // SimGrid consumes its own --cfg/--log arguments, so initialize the engine first.
+    Engine e(&argc, argv);
+
+    GridOptions options;
+    ErrorCodeTable dictionary;
+    vector<SiteSpec> specs;
+    JobLengthConfig lengths;
+    ErrorRegimeSpec regimes;
+    unique_ptr<BrokeragePolicy> policy;
+    try {
+        options = parseArguments(argc, argv);
+        if (!options.replay_file.empty()) {
+            JobRecordReader check(options.replay_file);  // fail before the run if the file cannot be opened
+        }
+        policy = makeBrokeragePolicy(options.policy);
+        g_packing = parsePacking(options.packing);
+        dictionary = loadErrorCodes(options.input_file);
+        specs = loadSiteSpecs(options.catalog_file, dictionary, options.scale, options.sites);
+        for (SiteSpec& spec : specs) {
+            if (options.cores > 0) {
+                spec.cores = options.cores;
+            }
+            if (options.memory_per_core > 0) {
+                spec.memory_per_core = options.memory_per_core;
+            }
+        }
+        g_oomSigma = options.oom_sigma;
+        g_negotiationInterval = options.negotiation_interval;
+
+        // Retryable error codes are checked against the historical codes of all selected sites.
+        map<string, int> known_codes;
+        for (const SiteSpec& spec : specs) {
+            for (const auto& [code, count] : dictionary[spec.name]) {
+                known_codes[code] += count;
+            }
+        }
+        g_retryPolicy = parseRetryPolicy(options.max_attempts, options.retry_backoff, options.retry_backoff_factor, options.retry_codes,
+                                         known_codes);
+        g_failureTiming = options.failure_timing_file.empty() ? make_unique<FailureTimingModel>()
+                                                              : make_unique<FailureTimingModel>(options.failure_timing_file);
+        if (!options.job_length_model.empty()) {
+            lengths = JobLengthConfig(options.job_length_model);
+        }
+        if (!options.error_regimes_file.empty()) {
+            regimes = loadErrorRegimes(options.error_regimes_file);
+        }
+        if (!options.input_size_model.empty()) {
+            g_inputSize = make_unique<JobLengthSampler>(parseJobLengthSpec(options.input_size_model), 0.0);
+        }
+        if (!options.output_size_model.empty()) {
+            g_outputSize = make_unique<JobLengthSampler>(parseJobLengthSpec(options.output_size_model), 0.0);
+        }
+    } catch (const exception& ex) {
+        cerr << ex.what() << endl;
+        return EXIT_FAILURE;
+    }
+    if (specs.empty()) {
+        cerr << "Error: No sites selected" << endl;
+        return EXIT_FAILURE;
+    }
+
+    // Build the hierarchical platform, one zone per site.
+    GridPlatform platform = createGridPlatform(specs);
+
+    long total_hosts = 0;
+    g_sites.resize(specs.size());
+    for (size_t s = 0; s < specs.size(); s++) {
+        Site& site = g_sites[s];
+        site.spec = specs[s];
+        site.errors = make_unique<ErrorCodeGenerator>(dictionary[site.spec.name]);
+        // Every site follows its own regime chain, so outages at different sites are independent.
+        if (!options.error_regimes_file.empty()) {
+            site.regimes = make_unique<TimeVaryingErrorGenerator>(regimes, dictionary[site.spec.name]);
+        }
+        site.lengths = make_unique<JobLengthSampler>(lengths.forQueue(site.spec.name));
+        site.failure_probability = failureFraction(dictionary[site.spec.name]);
+        site.mbox = Mailbox::by_name(site.spec.name);
+        site.hosts = platform.site_hosts[s];
+        site.storage = platform.site_storage[s];
+        site.storage_disk = platform.site_storage_disks[s];
+        site.cores = CorePacker(static_cast<int>(site.hosts.size()), site.spec.cores, site.spec.cores * site.spec.memory_per_core);
+        if (g_packing == Packing::Easy) {
+            site.profile = AvailabilityProfile(static_cast<int>(site.hosts.size()), site.spec.cores,
+                                               site.spec.cores * site.spec.memory_per_core);
+        }
+        total_hosts += static_cast<long>(site.hosts.size());
+    }
+    cout << "Input File: " << options.input_file << endl;
+    cout << "Site Catalog: " << options.catalog_file << endl;
+    if (options.replay_file.empty()) {
+        cout << "Number of jobs: " << options.num_jobs << endl;
+    } else {
+        cout << "Replay: " << options.replay_file << endl;
+    }
+    cout << "Sites: " << g_sites.size() << ", hosts: " << total_hosts << endl;
+    cout << "Brokerage policy: " << options.policy << endl;
+    cout << "Packing policy: " << options.packing << ", multi-core jobs: " << options.multicore_fraction * 100.0
+         << "% with " << options.multicore_cores << " cores" << endl;
+    cout << "Memory requests: " << options.job_memory << " MB per core, " << options.highmem_fraction * 100.0
+         << "% high-memory jobs with " << options.highmem_memory << " MB per core" << endl;
+
+    // The replay master counts its jobs as it reads them and holds one unit until the end of the file.
+    g_unfinishedJobs = options.replay_file.empty() ? options.num_jobs : 1;
+    g_allJobsDone = Semaphore::create(0);
+    if (g_retryPolicy.enabled()) {
+        g_retryMailbox = Mailbox::by_name("retries");
+    }
+
+    // Pick the actor instantiation once; a quiet build (SIM_LOG_LEVEL=0) never instantiates the verbose one.
+    if constexpr (kLoggingCompiledIn) {
+        if (muted)
+            create_actors<false>(platform.server, options, policy.get());
+        else
+            create_actors<true>(platform.server, options, policy.get());
+    } else {
+        create_actors<false>(platform.server, options, policy.get());
+    }
+
+    e.run();
+    if (!options.replay_file.empty()) {
+        options.num_jobs = g_replayedJobs;
+    }
+
+    // After simulation run is finished, print a summary.
+    double sim_hours = Engine::get_clock() / 3600.0;
+    long total_success = 0;
+    long total_failures = 0;
+    double wasted_hours = 0.0;
+    double useful_hours = 0.0;
+    double retry_hours = 0.0;
+    long total_attempts = 0;
+    map<int, long> error_counts;
+    for (const Site& site : g_sites) {
+        total_success += site.succeeded;
+        total_failures += site.failed;
+        total_attempts += site.attempts;
+        retry_hours += site.busy_time_retries / 3600.0;
+        wasted_hours += site.busy_time_failed / 3600.0;
+        useful_hours += site.busy_time_succeeded / 3600.0;
+        for (const auto& kv : site.error_counts) {
+            error_counts[kv.first] += kv.second;
+        }
+    }
+
+    cout << "\n=== Simulation Summary ===" << endl;
+    cout << "Total jobs: " << options.num_jobs << endl;
+    cout << "Successful jobs: " << total_success << endl;
+    cout << "Failed jobs: " << total_failures << endl;
+    cout << "Simulated time: " << Engine::get_clock() << " s" << endl;
+    if (sim_hours > 0) {
+        cout << "Throughput: " << total_success / sim_hours << " successful jobs per simulated hour" << endl;
+    }
+    cout << "CPU time on successful jobs: " << useful_hours << " h" << endl;
+    cout << "CPU time wasted on failed jobs: " << wasted_hours << " h";
+    if (useful_hours + wasted_hours > 0) {
+        cout << " (" << 100.0 * wasted_hours / (useful_hours + wasted_hours) << "%)";
+    }
+    cout << endl;
+    if (total_failures > 0) {
+        cout << "Failure details:" << endl;
+        for (const auto& kv : error_counts) {
+            cout << "  Error code " << kv.first << ": " << kv.second << endl;
+        }
+    }
+    if (!regimes.regimes.empty()) {
+        long switches = 0;
+        vector<long> draws(regimes.regimes.size(), 0);
+        vector<long> failures(regimes.regimes.size(), 0);
+        for (const Site& site : g_sites) {
+            switches += site.regimes->switches();
+            for (size_t r = 0; r < regimes.regimes.size(); r++) {
+                draws[r] += site.regimes->draws(r);
+                failures[r] += site.regimes->failures(r);
+            }
+        }
+        cout << "Error regimes (" << switches << " regime changes over all sites):" << endl;
+        for (size_t r = 0; r < regimes.regimes.size(); r++) {
+            cout << "  " << regimes.regimes[r].name << ": " << draws[r] << " jobs, failure rate "
+                 << (draws[r] > 0 ? 100.0 * failures[r] / draws[r] : 0.0) << "%" << endl;
+        }
+    }
+    if (!g_wastedTimeByCode.empty()) {
+        cout << "Wasted CPU time by error code:" << endl;
+        for (const auto& kv : g_wastedTimeByCode) {
+            cout << "  Error code " << kv.first << ": " << kv.second / 3600.0 << " h" << endl;
+        }
+    }
+    if (g_retryPolicy.enabled()) {
+        cout << "Retry policy: up to " << g_retryPolicy.max_attempts << " attempts, backoff "
+             << g_retryPolicy.backoff << " s (x" << g_retryPolicy.backoff_factor << "), retryable codes: ";
+        if (g_retryPolicy.retryable_codes.empty()) {
+            cout << "all";
+        }
+        for (int code : g_retryPolicy.retryable_codes) {
+            cout << code << " ";
+        }
+        cout << endl;
+        cout << "Attempts: " << total_attempts << " (" << total_attempts - options.num_jobs << " retries)" << endl;
+        cout << "Retry amplification: " << (options.num_jobs > 0 ? static_cast<double>(total_attempts) / options.num_jobs : 0.0) << endl;
+        cout << "CPU time spent on retries: " << retry_hours << " h" << endl;
+        cout << "Retried error codes:" << endl;
+        for (const auto& kv : g_retriedErrorCounts) {
+            cout << "  Error code " << kv.first << ": " << kv.second << endl;
+        }
+    }
+
+    cout << "\nPer-site results:" << endl;
+    // Jobs counts the jobs that ended at the site; the success/h column is the effective throughput of the site.
+    cout << left << setw(34) << "  Site" << right << setw(8) << "Hosts" << setw(10) << "Jobs" << setw(10) << "Success"
+         << setw(10) << "Failed" << setw(12) << "Fail rate" << setw(12) << "Hist. rate" << setw(14) << "Wasted [h]"
+         << setw(10) << "Attempts" << setw(10) << "Retried" << setw(12) << "Retry [h]" << setw(12) << "Success/h" << endl;
+    for (const Site& site : g_sites) {
+        long jobs = site.succeeded + site.failed;
+        cout << left << setw(34) << "  " + site.spec.name << right << setw(8) << site.hosts.size() << setw(10) << jobs
+             << setw(10) << site.succeeded << setw(10) << site.failed << setw(12) << fixed << setprecision(4)
+             << (jobs > 0 ? static_cast<double>(site.failed) / jobs : 0.0) << setw(12) << site.failure_probability
+             << setw(14) << setprecision(2) << site.busy_time_failed / 3600.0
+             << setw(10) << site.attempts << setw(10) << site.retried << setw(12) << site.busy_time_retries / 3600.0
+             << setw(12) << (sim_hours > 0 ? site.succeeded / sim_hours : 0.0) << defaultfloat << endl;
+    }
+    // Core packing: utilization is the share of core time in use; idle-while-waiting is the share of core time
+    // left idle although jobs were waiting, i.e. lost to fragmentation or to hosts drained for wide jobs.
+    // Memory utilization is the share of host memory requested by running jobs.
+    double core_time = 0.0, core_busy = 0.0, core_idle_waiting = 0.0, memory_time = 0.0, memory_busy = 0.0;
+    long oom_kills = 0;
+    for (Site& site : g_sites) {
+        accountCores(site);
+        core_time += static_cast<double>(site.hosts.size()) * site.cores.coresPerHost() * Engine::get_clock();
+        core_busy += site.core_busy_time;
+        core_idle_waiting += site.core_idle_waiting;
+        memory_time += static_cast<double>(site.hosts.size()) * site.cores.memoryPerHost() * Engine::get_clock();
+        memory_busy += site.memory_busy_time;
+        oom_kills += site.oom_kills;
+    }
+    if (core_time > 0) {
+        cout << "Core utilization: " << 100.0 * core_busy / core_time << "%, idle while jobs were waiting: "
+             << 100.0 * core_idle_waiting / core_time << "%" << endl;
+    }
+    if (memory_time > 0) {
+        cout << "Memory utilization: " << 100.0 * memory_busy / memory_time << "%" << endl;
+    }
+    if (g_packing == Packing::Easy || g_packing == Packing::Condor) {
+        long backfilled = 0, cycles = 0, started = 0;
+        for (const Site& site : g_sites) {
+            backfilled += site.backfilled;
+            cycles += site.negotiation_cycles;
+            started += site.started[0] + site.started[1];
+        }
+        if (g_packing == Packing::Easy) {
+            cout << "Jobs started by backfilling: " << backfilled << " (" << (started > 0 ? 100.0 * backfilled / started : 0.0)
+                 << "% of all starts)" << endl;
+        } else {
+            cout << "Negotiation cycles: " << cycles << " (every " << g_negotiationInterval << " s)" << endl;
+        }
+    }
+    if (g_oomSigma > 0) {
+        cout << "Attempts killed for exceeding their memory request (error code " << OOM_ERROR_CODE << "): " << oom_kills << endl;
+    }
+    cout << "\nPer-site packing:" << endl;
+    cout << left << setw(34) << "  Site" << right << setw(8) << "Hosts" << setw(8) << "Cores" << setw(12) << "Mem [MB]"
+         << setw(12) << "Core util" << setw(12) << "Mem util" << setw(14) << "Idle waiting" << setw(14) << "Wait 1c [s]"
+         << setw(14) << "Wait mc [s]" << setw(10) << "OOM" << endl;
+    for (const Site& site : g_sites) {
+        double site_core_time = static_cast<double>(site.hosts.size()) * site.cores.coresPerHost() * Engine::get_clock();
+        double site_memory_time = static_cast<double>(site.hosts.size()) * site.cores.memoryPerHost() * Engine::get_clock();
+        cout << left << setw(34) << "  " + site.spec.name << right << setw(8) << site.hosts.size() << setw(8) << site.cores.coresPerHost()
+             << fixed << setprecision(0) << setw(12) << site.cores.memoryPerHost() << setprecision(4)
+             << setw(12) << (site_core_time > 0 ? site.core_busy_time / site_core_time : 0.0)
+             << setw(12) << (site_memory_time > 0 ? site.memory_busy_time / site_memory_time : 0.0)
+             << setw(14) << (site_core_time > 0 ? site.core_idle_waiting / site_core_time : 0.0) << setprecision(1)
+             << setw(14) << (site.started[0] > 0 ? site.wait_time[0] / site.started[0] : 0.0)
+             << setw(14) << (site.started[1] > 0 ? site.wait_time[1] / site.started[1] : 0.0) << defaultfloat
+             << setw(10) << site.oom_kills << endl;
+    }
+    if (g_inputSize || g_outputSize) {
+        // Staging time per attempt grows once concurrent jobs saturate the storage element of a site.
+        cout << "\nPer-site storage:" << endl;
+        cout << left << setw(34) << "  Site" << right << setw(8) << "Hosts" << setw(12) << "In [GB]" << setw(12) << "Out [GB]"
+             << setw(12) << "Stage [h]" << setw(14) << "Stage/job [s]" << setw(14) << "Stage share" << endl;
+        for (const Site& site : g_sites) {
+            double busy = site.busy_time_succeeded + site.busy_time_failed + site.stage_time;
+            cout << left << setw(34) << "  " + site.spec.name << right << setw(8) << site.hosts.size() << fixed << setprecision(2)
+                 << setw(12) << site.bytes_in / 1e9 << setw(12) << site.bytes_out / 1e9 << setw(12) << site.stage_time / 3600.0
+                 << setw(14) << (site.attempts > 0 ? site.stage_time / site.attempts : 0.0)
+                 << setw(14) << (busy > 0 ? site.stage_time / busy : 0.0) << defaultfloat << endl;
+        }
+    }
+    if (!options.replay_file.empty()) {
+        // Recorded time span: from the first submission to the latest recorded end (submit time plus walltime); the
+        // simulated one adds the queue waits. CPU time is compared separately for successes and failures: recorded
+        // successes against the simulated successful jobs, and the recorded time to failure of the failed records
+        // against the simulated failed attempts (including retried ones), which end at their simulated time to failure.
+        long recorded_failed = 0;
+        double recorded_succeeded_time = 0.0, recorded_failed_time = 0.0;
+        for (const Site& site : g_sites) {
+            recorded_failed += site.recorded_failed;
+            recorded_succeeded_time += site.recorded_core_time_succeeded;
+            recorded_failed_time += site.recorded_core_time_failed;
+        }
+        cout << "\nReplay validation (" << g_replayedJobs << " jobs replayed, " << g_skippedRecords
+             << " records of other sites skipped";
+        if (!g_replayError.empty()) {
+            cout << ", partial: stopped at line " << g_replayErrorLine;
+        }
+        cout << "):" << endl;
+        cout << "  Time span: recorded " << g_recordedEnd << " s, simulated " << Engine::get_clock() << " s" << endl;
+        cout << "  Failure rate: recorded " << (g_replayedJobs > 0 ? 100.0 * recorded_failed / g_replayedJobs : 0.0)
+             << "%, simulated " << (g_replayedJobs > 0 ? 100.0 * total_failures / g_replayedJobs : 0.0) << "%" << endl;
+        cout << "  CPU time of successful jobs: recorded " << recorded_succeeded_time / 3600.0 << " h, simulated "
+             << useful_hours << " h" << endl;
+        cout << "  CPU time of failed jobs: recorded " << recorded_failed_time / 3600.0 << " h, simulated "
+             << wasted_hours << " h" << endl;
+        map<int, pair<long, long>> codes;  // error code -> recorded, simulated
+        for (const auto& kv : g_recordedErrorCounts) {
+            codes[kv.first].first = kv.second;
+        }
+        for (const auto& kv : error_counts) {
+            codes[kv.first].second = kv.second;
+        }
+        cout << left << setw(16) << "  Error code" << right << setw(12) << "Recorded" << setw(12) << "Simulated" << endl;
+        for (const auto& [code, counts] : codes) {
+            cout << left << setw(16) << "  " + to_string(code) << right << setw(12) << counts.first << setw(12) << counts.second << endl;
+        }
+        cout << left << setw(34) << "  Site" << right << setw(10) << "Jobs" << setw(12) << "Rec. fail" << setw(12) << "Sim. fail"
+             << setw(16) << "Rec. OK [h]" << setw(16) << "Sim. OK [h]" << setw(16) << "Rec. fail [h]" << setw(16)
+             << "Sim. fail [h]" << endl;
+        for (const Site& site : g_sites) {
+            if (site.recorded_jobs == 0) {
+                continue;
+            }
+            long jobs = site.succeeded + site.failed;
+            cout << left << setw(34) << "  " + site.spec.name << right << setw(10) << site.recorded_jobs << fixed << setprecision(4)
+                 << setw(12) << static_cast<double>(site.recorded_failed) / site.recorded_jobs
+                 << setw(12) << (jobs > 0 ? static_cast<double>(site.failed) / jobs : 0.0) << setprecision(2)
+                 << setw(16) << site.recorded_core_time_succeeded / 3600.0 << setw(16) << site.busy_time_succeeded / 3600.0
+                 << setw(16) << site.recorded_core_time_failed / 3600.0 << setw(16) << site.busy_time_failed / 3600.0
+                 << defaultfloat << endl;
+        }
+    }
+    cout << "==========================\n" << endl;
+
+    if (!g_replayError.empty()) {
+        cerr << g_replayError << endl;
+        cerr << "Error: The replay stopped at line " << g_replayErrorLine << " of " << options.replay_file
+             << "; the summary only covers the " << g_replayedJobs << " jobs submitted before it." << endl;
+        return EXIT_FAILURE;
+    }
+    return 0;
+}